@@ -0,0 +1,178 @@
+#include "BatchTextureFilter.h"
+
+static uint32 GetBatchConcurrency(const FBatchFilterParameters& InParameters)
+{
+	return InParameters.MaxConcurrency > 0 ? uint32(InParameters.MaxConcurrency) : FMath::Max(LowLevelTasks::FScheduler::Get().GetNumWorkers(), 1u);
+}
+
+//Keeps the pixels of InOutImage(they are overwritten anyway) unless the size or format changes.
+static FImageView PrepareScratchImage(FImage& InOutImage, int32 InSizeX, int32 InSizeY, ERawImageFormat::Type InFormat, EGammaSpace InGammaSpace)
+{
+	if (InOutImage.SizeX != InSizeX || InOutImage.SizeY != InSizeY || InOutImage.Format != InFormat || InOutImage.GammaSpace != InGammaSpace)
+	{
+		InOutImage.Init(InSizeX, InSizeY, InFormat, InGammaSpace);
+	}
+
+	return FImageView(InOutImage, InOutImage.RawData.GetData());
+}
+
+FBatchTextureFilter::FBatchTextureFilter(TConstArrayView<UTexture2D*> InSourceTextures, const FBatchFilterParameters& InParameters)
+	:Parameters(InParameters), QoS(FFilterQoS::Make(EFilterQoS::Batch, 0.0f)), CancellationToken(MakeShared<UE::Tasks::FCancellationToken, ESPMode::ThreadSafe>()),
+	Limiter(GetBatchConcurrency(InParameters), LowLevelTasks::ETaskPriority::BackgroundLow)
+{
+	for (UTexture2D* SourceTexture : InSourceTextures)
+	{
+		SourceTextures.Add(SourceTexture);
+	}
+
+	Slots.SetNum(GetBatchConcurrency(InParameters));
+
+	const EConvolutionType ConvolutionTypes[] = { EConvolutionType::OneDVertical, EConvolutionType::OneDHorizontal };
+
+	for (int32 Pass = 0; Pass < UE_ARRAY_COUNT(ConvolutionTypes); ++Pass)
+	{
+		FMemMark Mark(FMemStack::Get());
+
+		FFilterWeights PassWeights;
+		FFilterOffsets PassOffsets;
+
+		ComputeFilterKernel(Parameters.FilterType, Parameters.FilterSize, ConvolutionTypes[Pass], PassWeights, PassOffsets);
+
+		Weights[Pass].Append(PassWeights);
+		Offsets[Pass].Append(PassOffsets);
+	}
+}
+
+FBatchTextureFilterRef FBatchTextureFilter::Launch(TConstArrayView<UTexture2D*> InSourceTextures, const FBatchFilterParameters& InParameters)
+{
+	check(IsInGameThread());
+
+	FBatchTextureFilterRef Batch = MakeShared<FBatchTextureFilter, ESPMode::ThreadSafe>(InSourceTextures, InParameters);
+
+	Batch->LaunchTime = FPlatformTime::Seconds();
+	Batch->NumPending.store(InSourceTextures.Num(), std::memory_order_relaxed);
+
+	//Holds the batch until the last upload, the limiter tasks and the uploads only reference it.
+	Batch->CompletionTask = FGameThreadFinalizeQueue::Get().Launch(
+		UE_SOURCE_LOCATION,
+		[Batch]()
+		{
+			UE_LOG(LogThreadingSample, Display, TEXT("Batch Texture Filter(%s, Textures: %d, Filter Size: %d, Concurrency: %d) Execution %s in %f Seconds."),
+				EFilterTypeToString(Batch->Parameters.FilterType),
+				Batch->Results.Num(), Batch->Parameters.FilterSize, Batch->Slots.Num(),
+				Batch->IsCanceled() ? TEXT("Canceled") : TEXT("Finished"),
+				FPlatformTime::Seconds() - Batch->LaunchTime);
+		},
+		Batch->CompletionEvent
+	);
+
+	if (InSourceTextures.Num() == 0)
+	{
+		Batch->CompletionEvent.Trigger();
+		return Batch;
+	}
+
+	//The result textures are the output of the batch and all of them count towards its peak memory, only the working sets are limited.
+	//All of them are leased before the first one is processed, the results are held until the whole batch is done anyway.
+	for (UTexture2D* SourceTexture : InSourceTextures)
+	{
+		Batch->Results.Add(CreateTransientTextureFromSourceAsync(SourceTexture, TEXT("BatchResult")));
+	}
+
+	for (int32 Index = 0; Index < InSourceTextures.Num(); ++Index)
+	{
+		//Queued once the texture exists, the limiter tasks cannot wait for it.
+		UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[Batch = &Batch.Get(), Index]()
+			{
+				Batch->Limiter.Push(
+					TEXT("BatchTextureFilter"),
+					[Batch, Index](uint32 ConcurrencySlot)
+					{
+						Batch->ProcessTexture(Index, ConcurrencySlot);
+					});
+			},
+			UE::Tasks::Prerequisites(Batch->Results[Index]),
+			LowLevelTasks::ETaskPriority::BackgroundLow,
+			UE::Tasks::EExtendedTaskPriority::Inline
+		);
+	}
+
+	return Batch;
+}
+
+void FBatchTextureFilter::ProcessTexture(int32 InIndex, uint32 InSlot)
+{
+	UTexture2D* SourceTexture = SourceTextures[InIndex].Get();
+
+	if (CancellationToken->IsCanceled() || !SourceTexture)
+	{
+		FinishTexture(InIndex, false);
+		return;
+	}
+
+	QoS.YieldToInteractiveWork(CancellationToken.Get());
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Logged once the snapshot is released, the texture itself is not touched anymore by then.
+	FIntPoint TextureSize;
+
+	{
+		//Taken and released by the slot, so the sources of the textures waiting in the limiter stay unlocked.
+		FSourceImageRef SourceImage = AcquireSourceImageSnapshot(SourceTexture);
+		const FImageView& Source = SourceImage->GetView();
+		TextureSize = FIntPoint(Source.SizeX, Source.SizeY);
+
+		FSlotScratch& Scratch = Slots[InSlot];
+
+		const FImageView VerticalPassResult = Parameters.IntermediatePrecision == EIntermediatePrecision::EightBit ?
+			PrepareScratchImage(Scratch.VerticalPassResult, Source.SizeX, Source.SizeY, ERawImageFormat::BGRA8, Source.GammaSpace)
+			: PrepareScratchImage(Scratch.VerticalPassResult, Source.SizeX, Source.SizeY,
+				Parameters.IntermediatePrecision == EIntermediatePrecision::Half ? ERawImageFormat::RGBA16F : ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+		const FImageView BlurResult = PrepareScratchImage(Scratch.BlurResult, Source.SizeX, Source.SizeY, ERawImageFormat::BGRA8, Source.GammaSpace);
+		const FImageView ScaleAlphaResult = PrepareScratchImage(Scratch.ScaleAlphaResult, Source.SizeX, Source.SizeY, ERawImageFormat::BGRA8, Source.GammaSpace);
+
+		//Single threaded, the other slots keep the remaining workers busy.
+		FilterTextureRows(Source, VerticalPassResult, Weights[0], Offsets[0], 0, Source.SizeY);
+		QoS.YieldToInteractiveWork(CancellationToken.Get());
+
+		FilterTextureRows(VerticalPassResult, BlurResult, Weights[1], Offsets[1], 0, Source.SizeY);
+		QoS.YieldToInteractiveWork(CancellationToken.Get());
+
+		ScaleAlphaChannel(Source, ScaleAlphaResult, Parameters.ScaleValue, true, CancellationToken.Get(), QoS);
+
+		//Null if the source was garbage collected before the texture was created.
+		const FTaskImage ResultImage(Results[InIndex]);
+		if (ResultImage.IsAvailable())
+		{
+			FScopedTaskImageAccess Result(ResultImage, LOCK_READ_WRITE);
+			CompositeRGBAValue(BlurResult, ScaleAlphaResult, Result.GetView(), true, CancellationToken.Get(), QoS);
+		}
+	}
+
+	UE_LOG(LogThreadingSample, Verbose, TEXT("Batch Texture Filter(Texture %d, Slot %u, Texture Size: %dx%d) Execution %s in %f Seconds."),
+		InIndex, InSlot, TextureSize.X, TextureSize.Y,
+		CancellationToken->IsCanceled() ? TEXT("Canceled") : TEXT("Finished"),
+		FPlatformTime::Seconds() - StartTime);
+
+	FinishTexture(InIndex, true);
+}
+
+void FBatchTextureFilter::FinishTexture(int32 InIndex, bool InProcessed)
+{
+	FGameThreadFinalizeQueue::Get().Enqueue([Batch = AsShared(), InIndex, InProcessed]()
+		{
+			UTexture2D* ResultTexture = GetTransientTexture(Batch->Results[InIndex]);
+			if (InProcessed && !Batch->IsCanceled() && ResultTexture)
+			{
+				UploadTextureRegions(ResultTexture);
+			}
+
+			if (Batch->NumPending.fetch_sub(1, std::memory_order_relaxed) == 1)
+			{
+				Batch->CompletionEvent.Trigger();
+			}
+		});
+}
@@ -0,0 +1,160 @@
+#include "CustomBPNodes/WaitForFilterResultUsingBlueprintAsyncActionBase.h"
+
+#include "ThreadingSampleBPLibrary.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(WaitForFilterResultUsingBlueprintAsyncActionBase)
+
+UAsyncWaitForFilterResult::UAsyncWaitForFilterResult(const FObjectInitializer& ObjectInitializer) :Super(ObjectInitializer)
+{
+	if (HasAnyFlags(RF_ClassDefaultObject) == false)
+	{
+		AddToRoot();
+	}
+}
+
+UAsyncWaitForFilterResult* UAsyncWaitForFilterResult::WaitForTaskSystemResult(UResultUsingTaskSystem* InResult)
+{
+	UAsyncWaitForFilterResult* WaitTask = NewObject<UAsyncWaitForFilterResult>();
+
+	if (InResult)
+	{
+		WaitTask->WaitForPreview(InResult->GetPreviewCompletionTask(), [InResult]() { return InResult->GetPreview(); });
+		WaitTask->Start(InResult, InResult->GetCompletionTask(), [InResult]() { return InResult->GetResult(); });
+	}
+	else
+	{
+		WaitTask->Start(nullptr, UE::Tasks::MakeCompletedTask<void>(), []() { return nullptr; });
+	}
+
+	return WaitTask;
+}
+
+UAsyncWaitForFilterResult* UAsyncWaitForFilterResult::WaitForTaskGraphSystemResult(UResultUsingTaskGraphSystem* InResult)
+{
+	UAsyncWaitForFilterResult* WaitTask = NewObject<UAsyncWaitForFilterResult>();
+
+	if (InResult)
+	{
+		WaitTask->WaitForPreview(InResult->GetPreviewCompletionTask(), [InResult]() { return InResult->GetPreview(); });
+		//The finalize queue takes UE::Tasks tasks as prerequisites.
+		WaitTask->Start(InResult, MakeTaskFromGraphEvent(InResult->GetCompletionEvent()), [InResult]() { return InResult->GetResult(); });
+	}
+	else
+	{
+		WaitTask->Start(nullptr, UE::Tasks::MakeCompletedTask<void>(), []() { return nullptr; });
+	}
+
+	return WaitTask;
+}
+
+UAsyncWaitForFilterResult* UAsyncWaitForFilterResult::WaitForPipeResult(UResultUsingPipe* InResult)
+{
+	UAsyncWaitForFilterResult* WaitTask = NewObject<UAsyncWaitForFilterResult>();
+
+	if (InResult)
+	{
+		WaitTask->WaitForPreview(InResult->GetPreviewCompletionTask(), [InResult]() { return InResult->GetPreview(); });
+		WaitTask->Start(InResult, InResult->GetCompletionTask(), [InResult]() { return InResult->GetResult(); });
+	}
+	else
+	{
+		WaitTask->Start(nullptr, UE::Tasks::MakeCompletedTask<void>(), []() { return nullptr; });
+	}
+
+	return WaitTask;
+}
+
+UAsyncWaitForFilterResult* UAsyncWaitForFilterResult::WaitForBatchResult(UBatchFilterResult* InResult)
+{
+	UAsyncWaitForFilterResult* WaitTask = NewObject<UAsyncWaitForFilterResult>();
+
+	if (InResult)
+	{
+		WaitTask->Start(InResult, InResult->GetCompletionTask(), []() { return nullptr; }, [InResult]() { return !InResult->IsCanceled(); });
+	}
+	else
+	{
+		WaitTask->Start(nullptr, UE::Tasks::MakeCompletedTask<void>(), []() { return nullptr; });
+	}
+
+	return WaitTask;
+}
+
+void UAsyncWaitForFilterResult::Start(UObject* InResult, const UE::Tasks::FTask& InCompletionTask, TFunction<UTexture2D*()> InGetTexture, TFunction<bool()> InIsSucceeded)
+{
+	Result = InResult;
+	GetTexture = MoveTemp(InGetTexture);
+	IsSucceeded = MoveTemp(InIsSucceeded);
+
+	//Even a completed request is broadcasted from the queue, so the delegates can be bound after the node returns.
+	FGameThreadFinalizeQueue::Get().Launch(
+		UE_SOURCE_LOCATION,
+		[this]()
+		{
+			HandleFilterFinished();
+		},
+		InCompletionTask
+	);
+}
+
+void UAsyncWaitForFilterResult::WaitForPreview(const UE::Tasks::FTask& InPreviewTask, TFunction<UTexture2D*()> InGetPreview)
+{
+	if (!InPreviewTask.IsValid())
+	{
+		return;
+	}
+
+	GetPreview = MoveTemp(InGetPreview);
+
+	//May run after HandleFilterFinished() if the full result was quicker, this node could be garbage collected by then.
+	FGameThreadFinalizeQueue::Get().Launch(
+		UE_SOURCE_LOCATION,
+		[WeakThis = TWeakObjectPtr<UAsyncWaitForFilterResult>(this)]()
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->HandlePreviewFinished();
+			}
+		},
+		InPreviewTask
+	);
+}
+
+void UAsyncWaitForFilterResult::HandlePreviewFinished()
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	//Null if the preview was skipped or the request was canceled, OnSuccess or OnFailure follows anyway.
+	if (UTexture2D* Preview = GetPreview())
+	{
+		OnPreview.Broadcast(Preview);
+	}
+}
+
+void UAsyncWaitForFilterResult::HandleFilterFinished()
+{
+	bFinished = true;
+
+	UTexture2D* Texture = GetTexture();
+
+	if (IsSucceeded ? IsSucceeded() : Texture != nullptr)
+	{
+		OnSuccess.Broadcast(Texture);
+	}
+	else
+	{
+		OnFailure.Broadcast(nullptr);
+	}
+
+	//The broadcasted textures were exposed by the result object(see FTransientTextureLease::MarkExposed()),
+	//they stay out of the pool and alive as long as Blueprints reference them, even once the result object is collected.
+	Result = nullptr;
+	GetTexture.Reset();
+	IsSucceeded.Reset();
+	GetPreview.Reset();
+
+	RemoveFromRoot();
+}
@@ -0,0 +1,989 @@
+#include "FilterPipelineGraph.h"
+#include "WavefrontFilter.h"
+#include "TextureContentHash.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+//The task graph task of every node, the work itself is done by the request.
+class FFilterPipelineNodeTask
+{
+public:
+	FFilterPipelineNodeTask(FFilterPipelineRequestRef InRequest, int32 InNodeIndex)
+		:Request(MoveTemp(InRequest)), NodeIndex(InNodeIndex)
+	{
+	}
+
+	TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FFilterPipelineNodeTask, STATGROUP_TaskGraphTasks);
+	}
+
+	//Picked by the QoS class of the request.
+	ENamedThreads::Type GetDesiredThread() const
+	{
+		return Request->GetParameters().QoS.GetDesiredThread();
+	}
+
+	static ESubsequentsMode::Type GetSubsequentsMode()
+	{
+		return ESubsequentsMode::TrackSubsequents;
+	}
+
+	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+	{
+		Request->ExecuteNode(NodeIndex);
+	}
+
+private:
+	FFilterPipelineRequestRef Request;
+
+	int32 NodeIndex = INDEX_NONE;
+};
+
+const TCHAR* EFilterPipelineNodeToString(EFilterPipelineNode InNode)
+{
+	const TCHAR* ConvertTable[] = {
+		TEXT("VerticalPass"),
+		TEXT("HorizontalPass"),
+		TEXT("ScaleAlpha"),
+		TEXT("Composite"),
+		TEXT("Finalize")
+	};
+
+	return ConvertTable[int32(InNode)];
+}
+
+const TCHAR* EFilterPipelineBackendToString(EFilterPipelineBackend InBackend)
+{
+	const TCHAR* ConvertTable[] = {
+		TEXT("Tasks"),
+		TEXT("TaskGraph"),
+		TEXT("Pipe")
+	};
+
+	return ConvertTable[int32(InBackend)];
+}
+
+int32 FFilterPipelineGraph::AddResource(EFilterPipelineResource InType)
+{
+	check(!bCompiled && Resources.Num() < MaxResources);
+
+	FResource Resource;
+	Resource.Type = InType;
+
+	return Resources.Add(Resource);
+}
+
+int32 FFilterPipelineGraph::AddNode(EFilterPipelineNode InType, std::initializer_list<int32> InReads, int32 InWrite, TOptional<EPipelineStage> InStage)
+{
+	check(!bCompiled);
+	check(Nodes.Num() < MaxNodes && InReads.size() <= MaxReads);
+	check(InWrite == INDEX_NONE || Resources.IsValidIndex(InWrite));
+
+	FNode Node;
+	Node.Type = InType;
+	Node.Stage = InStage;
+	Node.Write = int8(InWrite);
+
+	for (int32 Read : InReads)
+	{
+		check(Resources.IsValidIndex(Read));
+		Node.Reads[Node.NumReads++] = int8(Read);
+	}
+
+	return Nodes.Add(Node);
+}
+
+bool FFilterPipelineGraph::IsImageResource(int32 InResourceIndex) const
+{
+	return Resources[InResourceIndex].Type != EFilterPipelineResource::ResultTexture;
+}
+
+bool FFilterPipelineGraph::Compile()
+{
+	check(!bCompiled);
+
+	auto Fail = [](int32 InNodeIndex, const TCHAR* InError)
+		{
+			UE_LOG(LogThreadingSample, Error, TEXT("Invalid filter pipeline graph(Node %d): %s"), InNodeIndex, InError);
+			return false;
+		};
+
+	if (Nodes.Num() == 0 || Nodes.Last().Type != EFilterPipelineNode::Finalize)
+	{
+		return Fail(Nodes.Num() - 1, TEXT("The last node has to be the finalize node."));
+	}
+
+	int32 NumSources = 0;
+	int32 NumResultTextures = 0;
+	for (const FResource& Resource : Resources)
+	{
+		NumSources += Resource.Type == EFilterPipelineResource::Source;
+		NumResultTextures += Resource.Type == EFilterPipelineResource::ResultTexture;
+	}
+
+	if (NumSources != 1 || NumResultTextures != 1)
+	{
+		return Fail(INDEX_NONE, TEXT("A pipeline has one source and one result texture."));
+	}
+
+	//Every access of a node, in submission order. A read waits for the writer of the resource, which is the only dependency there is.
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		FNode& Node = Nodes[NodeIndex];
+
+		switch (Node.Type)
+		{
+		case EFilterPipelineNode::VerticalPass:
+		case EFilterPipelineNode::HorizontalPass:
+		case EFilterPipelineNode::ScaleAlpha:
+			if (Node.NumReads != 1 || !IsImageResource(Node.Reads[0]) || Node.Write == INDEX_NONE || !IsImageResource(Node.Write))
+			{
+				return Fail(NodeIndex, TEXT("A pass reads one image and writes another one."));
+			}
+			if (!Node.Stage)
+			{
+				return Fail(NodeIndex, TEXT("A pass belongs to a stage, so it can be reused through the stage cache."));
+			}
+			break;
+		case EFilterPipelineNode::Composite:
+			if (Node.NumReads != 2 || !IsImageResource(Node.Reads[0]) || !IsImageResource(Node.Reads[1])
+				|| Node.Write == INDEX_NONE || Resources[Node.Write].Type != EFilterPipelineResource::ResultTexture || Node.Stage)
+			{
+				return Fail(NodeIndex, TEXT("The composite reads two images, writes the result texture and belongs to no stage."));
+			}
+			break;
+		case EFilterPipelineNode::Finalize:
+			if (NodeIndex != Nodes.Num() - 1 || Node.NumReads != 1 || Resources[Node.Reads[0]].Type != EFilterPipelineResource::ResultTexture
+				|| Node.Write != INDEX_NONE || Node.Stage)
+			{
+				return Fail(NodeIndex, TEXT("The finalize node is the last node, reads the result texture and belongs to no stage."));
+			}
+			break;
+		default:
+			return Fail(NodeIndex, TEXT("Unknown node type."));
+		}
+
+		for (int32 Read = 0; Read < Node.NumReads; ++Read)
+		{
+			FResource& Resource = Resources[Node.Reads[Read]];
+
+			if (Resource.ReaderMask & (1u << NodeIndex))
+			{
+				return Fail(NodeIndex, TEXT("A node reads a resource once."));
+			}
+
+			if (Resource.Type != EFilterPipelineResource::Source)
+			{
+				if (Resource.Writer == INDEX_NONE)
+				{
+					return Fail(NodeIndex, TEXT("The node reads a resource no node wrote before it."));
+				}
+
+				Node.DependencyMask |= 1u << Resource.Writer;
+			}
+
+			Resource.ReaderMask |= 1u << NodeIndex;
+		}
+
+		if (Node.Write != INDEX_NONE)
+		{
+			FResource& Resource = Resources[Node.Write];
+
+			if (Resource.Type == EFilterPipelineResource::Source || Resource.Writer != INDEX_NONE || (Resource.ReaderMask & (1u << NodeIndex)))
+			{
+				return Fail(NodeIndex, TEXT("Every resource but the source is written once, by a node not reading it."));
+			}
+
+			Resource.Writer = int8(NodeIndex);
+		}
+	}
+
+	for (int32 ResourceIndex = 0; ResourceIndex < Resources.Num(); ++ResourceIndex)
+	{
+		const FResource& Resource = Resources[ResourceIndex];
+		if (Resource.ReaderMask == 0 || (Resource.Type != EFilterPipelineResource::Source && Resource.Writer == INDEX_NONE))
+		{
+			UE_LOG(LogThreadingSample, Error, TEXT("Invalid filter pipeline graph(Resource %d): Every resource is written and read."), ResourceIndex);
+			return false;
+		}
+	}
+
+	//Stages are contiguous runs of nodes reading the source or what the stage wrote, only the image written by their last node is read outside of them.
+	bool bStageSeen[NumStages] = {};
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		FNode& Node = Nodes[NodeIndex];
+		if (!Node.Stage)
+		{
+			continue;
+		}
+
+		Node.bStageEntry = NodeIndex == 0 || Nodes[NodeIndex - 1].Stage != Node.Stage;
+		const bool bStageExit = NodeIndex == Nodes.Num() - 1 || Nodes[NodeIndex + 1].Stage != Node.Stage;
+
+		bool& bSeen = bStageSeen[int32(*Node.Stage)];
+		if (Node.bStageEntry)
+		{
+			if (bSeen)
+			{
+				return Fail(NodeIndex, TEXT("The nodes of a stage have to be added one after another."));
+			}
+			bSeen = true;
+		}
+
+		//The stage key only covers the source and the request parameters.
+		const FResource& ReadResource = Resources[Node.Reads[0]];
+		if (ReadResource.Type != EFilterPipelineResource::Source && Nodes[ReadResource.Writer].Stage != Node.Stage)
+		{
+			return Fail(NodeIndex, TEXT("A pass reads the source or an image written by its own stage."));
+		}
+
+		FResource& WrittenResource = Resources[Node.Write];
+
+		bool bReadOutside = false;
+		for (uint32 Readers = WrittenResource.ReaderMask; Readers; Readers &= Readers - 1)
+		{
+			bReadOutside |= Nodes[FMath::CountTrailingZeros(Readers)].Stage != Node.Stage;
+		}
+
+		if (bStageExit != bReadOutside)
+		{
+			return Fail(NodeIndex, TEXT("Only the image written by the last node of a stage is read outside of it."));
+		}
+
+		Node.bStageOutput = bStageExit;
+		WrittenResource.bRetained = bStageExit;
+	}
+
+	//Bit N is set if node N happens before the node, directly or not.
+	uint32 AncestorMasks[MaxNodes] = {};
+	bool bLaneContinued[MaxNodes] = {};
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		FNode& Node = Nodes[NodeIndex];
+
+		for (uint32 Dependencies = Node.DependencyMask; Dependencies; Dependencies &= Dependencies - 1)
+		{
+			const int32 Dependency = FMath::CountTrailingZeros(Dependencies);
+			AncestorMasks[NodeIndex] |= AncestorMasks[Dependency] | (1u << Dependency);
+
+			if (Node.Lane == INDEX_NONE && !bLaneContinued[Dependency])
+			{
+				bLaneContinued[Dependency] = true;
+				Node.Lane = Nodes[Dependency].Lane;
+			}
+		}
+
+		//The finalize node goes through the finalize queue, it has no lane.
+		if (Node.Lane == INDEX_NONE && Node.Type != EFilterPipelineNode::Finalize)
+		{
+			Node.Lane = int8(NumLanes++);
+		}
+
+		if (Node.Stage)
+		{
+			int32 StageOutput = NodeIndex;
+			while (!Nodes[StageOutput].bStageOutput)
+			{
+				++StageOutput;
+			}
+			Node.StageOutput = int8(StageOutput);
+		}
+
+		//LaunchWavefrontFilter() reads the source and writes the horizontal pass, the vertical pass is internal to it.
+		if (Node.Type == EFilterPipelineNode::VerticalPass && Resources[Node.Reads[0]].Type == EFilterPipelineResource::Source)
+		{
+			const uint32 ReaderMask = Resources[Node.Write].ReaderMask;
+			const int32 Reader = FMath::CountTrailingZeros(ReaderMask);
+
+			Node.bFusedIntoWavefront = FMath::CountBits(ReaderMask) == 1
+				&& Nodes[Reader].Type == EFilterPipelineNode::HorizontalPass
+				&& Nodes[Reader].Stage == Node.Stage
+				&& Nodes[Reader].DependencyMask == (1u << NodeIndex);
+		}
+	}
+
+	//Assigns the buffers, in the order the resources are written. A transient image takes over the buffer of earlier ones
+	//if every access to them happens before its writer(through the dependencies), so sharing a buffer never costs concurrency.
+	//Images kept by the stage cache get their own buffer. The source and the result texture are no buffers.
+	TArray<int32, TFixedAllocator<MaxResources>> WriteOrder;
+	for (int32 ResourceIndex = 0; ResourceIndex < Resources.Num(); ++ResourceIndex)
+	{
+		if (Resources[ResourceIndex].Type == EFilterPipelineResource::Image || Resources[ResourceIndex].Type == EFilterPipelineResource::Intermediate)
+		{
+			WriteOrder.Add(ResourceIndex);
+		}
+	}
+	WriteOrder.Sort([this](int32 A, int32 B) { return Resources[A].Writer < Resources[B].Writer; });
+
+	uint32 SlotAccessMasks[MaxResources] = {};
+	EFilterPipelineResource SlotTypes[MaxResources] = {};
+	bool bSlotShared[MaxResources] = {};
+
+	for (int32 ResourceIndex : WriteOrder)
+	{
+		FResource& Resource = Resources[ResourceIndex];
+		const uint32 AccessMask = Resource.ReaderMask | (1u << Resource.Writer);
+
+		for (int32 Slot = 0; Slot < NumSlots && !Resource.bRetained; ++Slot)
+		{
+			if (bSlotShared[Slot] && SlotTypes[Slot] == Resource.Type && (SlotAccessMasks[Slot] & ~AncestorMasks[Resource.Writer]) == 0)
+			{
+				Resource.Slot = int8(Slot);
+				break;
+			}
+		}
+
+		if (Resource.Slot == INDEX_NONE)
+		{
+			Resource.Slot = int8(NumSlots++);
+			SlotTypes[Resource.Slot] = Resource.Type;
+			bSlotShared[Resource.Slot] = !Resource.bRetained;
+		}
+
+		SlotAccessMasks[Resource.Slot] |= AccessMask;
+		SlotReads[Resource.Slot] += int8(FMath::CountBits(Resource.ReaderMask));
+	}
+
+	UE_LOG(LogThreadingSample, Verbose, TEXT("Compiled filter pipeline graph: %d nodes, %d lanes, %d image resources in %d buffers."),
+		Nodes.Num(), NumLanes, WriteOrder.Num(), NumSlots);
+
+	bCompiled = true;
+	return true;
+}
+
+const FFilterPipelineGraph& FFilterPipelineGraph::GetDefault()
+{
+	static const FFilterPipelineGraph DefaultGraph = []()
+		{
+			FFilterPipelineGraph Graph;
+
+			const int32 Source = Graph.AddResource(EFilterPipelineResource::Source);
+			const int32 VerticalPassResult = Graph.AddResource(EFilterPipelineResource::Intermediate);
+			const int32 BlurResult = Graph.AddResource(EFilterPipelineResource::Image);
+			const int32 ScaleAlphaResult = Graph.AddResource(EFilterPipelineResource::Image);
+			const int32 CompositeResult = Graph.AddResource(EFilterPipelineResource::ResultTexture);
+
+			Graph.AddNode(EFilterPipelineNode::VerticalPass, { Source }, VerticalPassResult, EPipelineStage::Blur);
+			Graph.AddNode(EFilterPipelineNode::HorizontalPass, { VerticalPassResult }, BlurResult, EPipelineStage::Blur);
+			Graph.AddNode(EFilterPipelineNode::ScaleAlpha, { Source }, ScaleAlphaResult, EPipelineStage::ScaleAlpha);
+			Graph.AddNode(EFilterPipelineNode::Composite, { BlurResult, ScaleAlphaResult }, CompositeResult);
+			Graph.AddNode(EFilterPipelineNode::Finalize, { CompositeResult }, INDEX_NONE);
+
+			verify(Graph.Compile());
+			return Graph;
+		}();
+
+	return DefaultGraph;
+}
+
+FFilterPipelinePipes MakeFilterPipelinePipes(const FFilterPipelineGraph& InGraph)
+{
+	check(InGraph.IsCompiled());
+
+	FFilterPipelinePipes Pipes;
+	for (int32 Lane = 0; Lane < InGraph.GetNumLanes(); ++Lane)
+	{
+		Pipes.Add(MakeUnique<UE::Tasks::FPipe>(TEXT("TextureFilterPipe")));
+	}
+
+	return Pipes;
+}
+
+bool HasPipedWork(const FFilterPipelinePipes& InPipes)
+{
+	return InPipes.ContainsByPredicate([](const TUniquePtr<UE::Tasks::FPipe>& InPipe) { return InPipe->HasWork(); });
+}
+
+FFilterPipelineRequest::FFilterPipelineRequest(const FFilterPipelineGraph& InGraph, FSourceImageRef InSourceImage, const FFilterPipelineParameters& InParameters)
+	:Graph(InGraph), SourceImage(MoveTemp(InSourceImage)), Parameters(InParameters), Cancellation(MakeShared<FFilterRequestCancellation, ESPMode::ThreadSafe>())
+{
+	check(Graph.IsCompiled());
+
+	for (int32 Slot = 0; Slot < FFilterPipelineGraph::MaxResources; ++Slot)
+	{
+		PendingSlotReads[Slot].store(Slot < Graph.GetNumSlots() ? Graph.GetNumSlotReads(Slot) : 0, std::memory_order_relaxed);
+	}
+}
+
+FFilterPipelineRequestRef FFilterPipelineRequest::Create(const FFilterPipelineGraph& InGraph, UTexture2D* InSourceTexture, const FFilterPipelineParameters& InParameters)
+{
+	//The passes reading the source overlap their execution. Calling Lock() and Unlock() on InSourceTexture from all of them could assert,
+	//so they share a read-only snapshot of it instead of a copy.
+	FFilterPipelineRequestRef Request = MakeShared<FFilterPipelineRequest, ESPMode::ThreadSafe>(InGraph, AcquireSourceImageSnapshot(InSourceTexture), InParameters);
+	Request->LaunchCachedResultLookup();
+
+	return Request;
+}
+
+void FFilterPipelineRequest::LaunchCachedResultLookup()
+{
+	//Keys both the result cache and the stage cache. A full pass over the source, so it is skipped if neither cache is enabled.
+	if (!FFilterResultCache::IsEnabled() && !FPipelineStageCache::IsEnabled())
+	{
+		CachedResult = UE::Tasks::MakeCompletedTask<FTransientTextureRef>();
+		return;
+	}
+
+	//Hashed by tasks, the calling thread never touches the pixels.
+	UE::Tasks::TTask<uint64> SourceHashTask = LaunchImageContentHash(SourceImage);
+
+	CachedResult = UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[Request = AsShared(), SourceHashTask, bResultCacheEnabled = FFilterResultCache::IsEnabled()]() mutable -> FTransientTextureRef
+		{
+			Request->SourceHash = SourceHashTask.GetResult();
+
+			if (!bResultCacheEnabled)
+			{
+				return nullptr;
+			}
+
+			const FFilterPipelineParameters& RequestParameters = Request->Parameters;
+			Request->CacheKey = MakeFilterResultKey(*Request->SourceHash, RequestParameters.FilterType, RequestParameters.FilterSize, RequestParameters.ScaleValue,
+				RequestParameters.IntermediatePrecision, false);
+
+			FTransientTextureRef Result = FFilterResultCache::Get().Find(*Request->CacheKey);
+			Request->bResultCached = Result.IsValid();
+
+			return Result;
+		},
+		UE::Tasks::Prerequisites(SourceHashTask),
+		LowLevelTasks::ETaskPriority::High,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+}
+
+void FFilterPipelineRequest::Launch(EFilterPipelineBackend InBackend, const FFilterPipelinePipes* InPipes, bool InHoldRootTasks)
+{
+	check(InBackend != EFilterPipelineBackend::Pipe || (InPipes && InPipes->Num() == Graph.GetNumLanes()));
+
+	LaunchTime = FPlatformTime::Seconds();
+
+	if (IsFilterPipelineProfilingEnabled())
+	{
+		static std::atomic<uint32> NumProfiledRequests{ 0 };
+
+		ProfileName = FString::Printf(TEXT("Filter Pipeline %s #%u"), EFilterPipelineBackendToString(InBackend), NumProfiledRequests.fetch_add(1, std::memory_order_relaxed) + 1);
+		TRACE_BEGIN_REGION(*ProfileName);
+	}
+
+	TArray<FGraphEventRef, TInlineAllocator<FFilterPipelineGraph::MaxNodes>> HeldEvents;
+
+	for (int32 StageIndex = 0; StageIndex < FFilterPipelineGraph::NumStages; ++StageIndex)
+	{
+		StageCancellations[StageIndex] = MakeShared<FPipelineStageCancellation, ESPMode::ThreadSafe>();
+		StageEvents[StageIndex].Emplace(TEXT("PipelineStage"));
+	}
+
+	//The stage lookup needs the source hash, so it runs once the result cache was looked up. It only starts once every node is launched,
+	//the stage entry nodes wait for it.
+	UE::Tasks::FTaskEvent NodesLaunched(TEXT("PipelineNodesLaunched"));
+	StageLookupTask = UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[Request = AsShared()]()
+		{
+			Request->LookUpStages();
+		},
+		UE::Tasks::Prerequisites(CachedResult, NodesLaunched),
+		Parameters.QoS.GetTaskPriority(),
+		UE::Tasks::EExtendedTaskPriority::None
+	);
+
+	const TConstArrayView<FFilterPipelineGraph::FNode> Nodes = Graph.GetNodes();
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const FFilterPipelineGraph::FNode& Node = Nodes[NodeIndex];
+
+		//Every node is launched, the nodes of a stage found in the stage cache skip their work(see ExecuteNode()).
+		LaunchNode(NodeIndex, InBackend, InPipes, InHoldRootTasks, HeldEvents);
+
+		//The readers of the stage wait for its event instead, the cached stage may replace it.
+		if (Node.bStageOutput)
+		{
+			UE::Tasks::FTaskEvent& StageEvent = *StageEvents[int32(*Node.Stage)];
+			if (Tasks[NodeIndex].IsValid())
+			{
+				StageEvent.AddPrerequisites(Tasks[NodeIndex]);
+			}
+
+			Tasks[NodeIndex] = StageEvent;
+			Events[NodeIndex] = nullptr;
+		}
+	}
+
+	NodesLaunched.Trigger();
+
+	//Let the tasks begin execute(Let the scheduler schedule the tasks to be executed on worker threads).
+	for (const FGraphEventRef& HeldEvent : HeldEvents)
+	{
+		HeldEvent->Unlock();
+	}
+
+	//Batch work yields while the request is in flight.
+	if (Parameters.QoS.Class == EFilterQoS::Interactive)
+	{
+		TrackInteractiveRequest(CompletionEvent.IsValid() ? MakeTaskFromGraphEvent(CompletionEvent) : CompletionTask);
+	}
+}
+
+void FFilterPipelineRequest::LaunchNode(int32 InNodeIndex, EFilterPipelineBackend InBackend, const FFilterPipelinePipes* InPipes, bool InHoldRootTasks, TArray<FGraphEventRef, TInlineAllocator<FFilterPipelineGraph::MaxNodes>>& OutHeldEvents)
+{
+	const FFilterPipelineGraph::FNode& Node = Graph.GetNodes()[InNodeIndex];
+	const TCHAR* DebugName = EFilterPipelineNodeToString(Node.Type);
+
+	AcquireWrittenBuffer(InNodeIndex);
+
+	//Only the final result is a texture. It is created asynchronously and the node writing it takes its creation task as a prerequisite.
+	const bool bWritesResultTexture = Node.Write != INDEX_NONE && Graph.GetResources()[Node.Write].Type == EFilterPipelineResource::ResultTexture;
+
+	if (InBackend == EFilterPipelineBackend::Tasks)
+	{
+		//Launched with the horizontal pass reading it.
+		if (Node.bFusedIntoWavefront)
+		{
+			return;
+		}
+
+		//Both 1D passes as a wavefront of row bands, the horizontal pass of a band starts as soon as its rows went through the vertical pass.
+		//It is launched by the stage lookup, unless the blur stage is found in the stage cache(see LaunchWavefront()).
+		const int32 VerticalPass = FMath::CountTrailingZeros(Node.DependencyMask);
+		if (Node.Type == EFilterPipelineNode::HorizontalPass && Node.DependencyMask != 0 && Graph.GetNodes()[VerticalPass].bFusedIntoWavefront)
+		{
+			WavefrontNode = InNodeIndex;
+			return;
+		}
+	}
+
+	//The only game thread work of the pipeline. Recycled textures are updated in place.
+	//Goes through the finalize queue(outside of the pipes, if any) so a burst of finished requests is spread over several frames.
+	if (Node.Type == EFilterPipelineNode::Finalize)
+	{
+		const int32 Composite = FMath::CountTrailingZeros(Node.DependencyMask);
+
+		if (InBackend == EFilterPipelineBackend::TaskGraph)
+		{
+			FGraphEventArray Prerequisites;
+			Prerequisites.Add(Events[Composite]);
+
+			//Dispatched by the finalize queue once done.
+			CompletionEvent = FGraphEvent::CreateGraphEvent();
+			Events[InNodeIndex] = CompletionEvent;
+
+			//The predefined task type which takes a function as its task body
+			FFunctionGraphTask::CreateAndDispatchWhenReady(
+				[&FinalizeQueue = FGameThreadFinalizeQueue::Get(), Request = AsShared(), InNodeIndex]() {
+					FinalizeQueue.Enqueue([Request, InNodeIndex]() {
+						//A canceled request skips the upload, the event is dispatched anyway.
+						Request->ExecuteNode(InNodeIndex);
+						Request->CompletionEvent->DispatchSubsequents();
+					});
+				},
+				TStatId{}, &Prerequisites, ENamedThreads::AnyHiPriThreadHiPriTask);
+		}
+		else
+		{
+			CompletionTask = FGameThreadFinalizeQueue::Get().Launch(DebugName, [Request = AsShared(), InNodeIndex]() { Request->ExecuteNode(InNodeIndex); }, Tasks[Composite]);
+			Tasks[InNodeIndex] = CompletionTask;
+		}
+
+		return;
+	}
+
+	if (InBackend == EFilterPipelineBackend::TaskGraph)
+	{
+		//Task graph tasks cannot take UE::Tasks tasks(reused stages, the result texture) as prerequisites directly.
+		FGraphEventArray Prerequisites;
+		for (uint32 Dependencies = Node.DependencyMask; Dependencies; Dependencies &= Dependencies - 1)
+		{
+			const int32 Dependency = FMath::CountTrailingZeros(Dependencies);
+			if (Events[Dependency].IsValid())
+			{
+				Prerequisites.Add(Events[Dependency]);
+			}
+			else if (Tasks[Dependency].IsValid())
+			{
+				Prerequisites.Add(MakeGraphEventFromTask(Tasks[Dependency]));
+			}
+		}
+
+		if (bWritesResultTexture)
+		{
+			Prerequisites.Add(MakeGraphEventFromTask(ResultTexture));
+		}
+
+		if (Node.bStageEntry)
+		{
+			Prerequisites.Add(MakeGraphEventFromTask(StageLookupTask));
+		}
+
+		//Construct and hold or construct and dispatch when ready.
+		//If construct and hold, the task will not start execute until we explicitly unlock it(And of course its subsequents will not execute).
+		if (InHoldRootTasks && Node.DependencyMask == 0)
+		{
+			Events[InNodeIndex] = TGraphTask<FFilterPipelineNodeTask>::CreateTask(&Prerequisites, ENamedThreads::GameThread).ConstructAndHold(AsShared(), InNodeIndex);
+			OutHeldEvents.Add(Events[InNodeIndex]);
+		}
+		else
+		{
+			Events[InNodeIndex] = TGraphTask<FFilterPipelineNodeTask>::CreateTask(&Prerequisites, ENamedThreads::GameThread).ConstructAndDispatchWhenReady(AsShared(), InNodeIndex);
+		}
+
+		//Other pipelines reuse the stage through the stage cache, which tracks it as a UE::Tasks task.
+		if (Node.bStageOutput)
+		{
+			Tasks[InNodeIndex] = MakeTaskFromGraphEvent(Events[InNodeIndex]);
+		}
+
+		return;
+	}
+
+	TArray<UE::Tasks::FTask, TInlineAllocator<FFilterPipelineGraph::MaxNodes>> Prerequisites;
+	for (uint32 Dependencies = Node.DependencyMask; Dependencies; Dependencies &= Dependencies - 1)
+	{
+		Prerequisites.Add(Tasks[FMath::CountTrailingZeros(Dependencies)]);
+	}
+
+	if (bWritesResultTexture)
+	{
+		Prerequisites.Add(ResultTexture);
+	}
+
+	//Whether the stage is found in the stage cache is only known once the source is hashed.
+	if (Node.bStageEntry)
+	{
+		Prerequisites.Add(StageLookupTask);
+	}
+
+	auto NodeBody = [Request = AsShared(), InNodeIndex]()
+		{
+			Request->ExecuteNode(InNodeIndex);
+		};
+
+	//Every lane has its own pipe, so the blur and the alpha scale still overlap.
+	Tasks[InNodeIndex] = InBackend == EFilterPipelineBackend::Pipe ?
+		(*InPipes)[Node.Lane]->Launch(DebugName, MoveTemp(NodeBody), Prerequisites, Parameters.QoS.GetTaskPriority(), UE::Tasks::EExtendedTaskPriority::None)
+		: UE::Tasks::Launch(DebugName, MoveTemp(NodeBody), Prerequisites, Parameters.QoS.GetTaskPriority(), UE::Tasks::EExtendedTaskPriority::None);
+}
+
+void FFilterPipelineRequest::ExecuteNode(int32 InNodeIndex)
+{
+	const FFilterPipelineGraph::FNode& Node = Graph.GetNodes()[InNodeIndex];
+
+	const UE::Tasks::FCancellationToken* CancellationToken = GetNodeToken(InNodeIndex).Get();
+
+	//Read by the finalize node only, every other node happens before it.
+	const bool bProfiling = !ProfileName.IsEmpty();
+	if (bProfiling)
+	{
+		if (Node.Type == EFilterPipelineNode::Finalize)
+		{
+			TRACE_END_REGION(*(ProfileName + TEXT(" Game Thread Wait")));
+		}
+
+		Timings[InNodeIndex].StartTime = FPlatformTime::Seconds();
+		Timings[InNodeIndex].ThreadId = FPlatformTLS::GetCurrentThreadId();
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(EFilterPipelineNodeToString(Node.Type));
+
+	//Set by the lookups, which every node waits for. The output of a found stage is the cached image, its nodes must not write it.
+	const bool bSkipped = Node.Type != EFilterPipelineNode::Finalize && (bResultCached || (Node.Stage && bStageFound[int32(*Node.Stage)]));
+
+	if (!bSkipped)
+	{
+		switch (Node.Type)
+		{
+		case EFilterPipelineNode::VerticalPass:
+			FilterTexture(GetResourceImage(Node.Reads[0]), GetResourceImage(Node.Write), Parameters.FilterType, Parameters.FilterSize, EConvolutionType::OneDVertical, false, CancellationToken, Parameters.QoS);
+			break;
+		case EFilterPipelineNode::HorizontalPass:
+			FilterTexture(GetResourceImage(Node.Reads[0]), GetResourceImage(Node.Write), Parameters.FilterType, Parameters.FilterSize, EConvolutionType::OneDHorizontal, false, CancellationToken, Parameters.QoS);
+			break;
+		case EFilterPipelineNode::ScaleAlpha:
+			ScaleAlphaChannel(GetResourceImage(Node.Reads[0]), GetResourceImage(Node.Write), Parameters.ScaleValue, false, CancellationToken, Parameters.QoS);
+			break;
+		case EFilterPipelineNode::Composite:
+			CompositeRGBAValue(GetResourceImage(Node.Reads[0]), GetResourceImage(Node.Reads[1]), GetResourceImage(Node.Write), false, CancellationToken, Parameters.QoS);
+			break;
+		case EFilterPipelineNode::Finalize:
+			Finalize();
+			break;
+		default:
+			checkNoEntry();
+			break;
+		}
+	}
+
+	if (bProfiling)
+	{
+		Timings[InNodeIndex].EndTime = FPlatformTime::Seconds();
+
+		//The finalize node has exactly one dependency, the node writing the result texture.
+		if (Node.Type == EFilterPipelineNode::Finalize)
+		{
+			ReportProfile();
+		}
+		else if (Graph.GetNodes().Last().DependencyMask & (1u << InNodeIndex))
+		{
+			TRACE_BEGIN_REGION(*(ProfileName + TEXT(" Game Thread Wait")));
+		}
+	}
+
+	ReleaseReads(InNodeIndex);
+}
+
+void FFilterPipelineRequest::ReportProfile()
+{
+	const FFilterPipelineProfile Profile = AnalyzeFilterPipelineRun(Graph, LaunchTime, MakeArrayView(Timings, Graph.GetNodes().Num()));
+
+	LogFilterPipelineProfile(Graph, ProfileName, Cancellation->IsCanceled(), Profile);
+
+	TRACE_END_REGION(*ProfileName);
+}
+
+void FFilterPipelineRequest::Finalize()
+{
+	check(IsInGameThread());
+
+	//The texture of a canceled request is neither uploaded nor cached, it goes back to the pool with the last reference to it.
+	if (Cancellation->IsCanceled())
+	{
+		return;
+	}
+
+	//Null if the source was garbage collected before the texture was created, the composite skipped it as well.
+	FTransientTextureRef Result = ResultTexture.GetResult();
+	if (!Result.IsValid())
+	{
+		OnFinalized.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	//A cached result is uploaded already.
+	if (!bResultCached)
+	{
+		UploadTextureRegions(Result->GetTexture());
+
+		if (CacheKey)
+		{
+			FFilterResultCache::Get().Add(*CacheKey, Result);
+		}
+	}
+
+	OnFinalized.ExecuteIfBound(MoveTemp(Result));
+}
+
+void FFilterPipelineRequest::AcquireWrittenBuffer(int32 InNodeIndex)
+{
+	const int32 Write = Graph.GetNodes()[InNodeIndex].Write;
+	if (Write == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FFilterPipelineGraph::FResource& Resource = Graph.GetResources()[Write];
+
+	switch (Resource.Type)
+	{
+	case EFilterPipelineResource::ResultTexture:
+		CompositeTexture = CreateTransientTextureFromSourceAsync(SourceImage->GetTexture(), TEXT("CompositeResult"));
+
+		//The composite node waits for it as well, so it knows whether to skip before it writes anything.
+		ResultTexture = UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[CachedResultTask = CachedResult, CompositeTextureTask = CompositeTexture]() mutable -> FTransientTextureRef
+			{
+				const FTransientTextureRef& Result = CachedResultTask.GetResult();
+				return Result.IsValid() ? Result : CompositeTextureTask.GetResult();
+			},
+			UE::Tasks::Prerequisites(CachedResult, CompositeTexture),
+			LowLevelTasks::ETaskPriority::High,
+			UE::Tasks::EExtendedTaskPriority::Inline
+		);
+		break;
+	case EFilterPipelineResource::Image:
+		//Still held if an earlier resource sharing the buffer has reads pending, which includes the reads of this one.
+		if (!Buffers[Resource.Slot].IsValid())
+		{
+			Buffers[Resource.Slot] = AcquireImageBufferFromSource(SourceImage->GetTexture());
+		}
+		break;
+	case EFilterPipelineResource::Intermediate:
+		if (!Buffers[Resource.Slot].IsValid())
+		{
+			Buffers[Resource.Slot] = AcquireIntermediateImageBuffer(SourceImage->GetTexture(), Parameters.IntermediatePrecision);
+		}
+		break;
+	default:
+		checkNoEntry();
+		break;
+	}
+}
+
+void FFilterPipelineRequest::ReleaseReads(int32 InNodeIndex)
+{
+	const FFilterPipelineGraph::FNode& Node = Graph.GetNodes()[InNodeIndex];
+
+	for (int32 Read = 0; Read < Node.NumReads; ++Read)
+	{
+		const int32 Slot = Graph.GetResources()[Node.Reads[Read]].Slot;
+
+		//Back to the pool(unless the stage cache or a wavefront still holds it), a later node or request may lease it right away.
+		if (Slot != INDEX_NONE && PendingSlotReads[Slot].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Buffers[Slot].Reset();
+		}
+	}
+}
+
+void FFilterPipelineRequest::LookUpStages()
+{
+	const TConstArrayView<FFilterPipelineGraph::FNode> Nodes = Graph.GetNodes();
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const FFilterPipelineGraph::FNode& Node = Nodes[NodeIndex];
+		if (!Node.Stage)
+		{
+			continue;
+		}
+
+		const int32 StageIndex = int32(*Node.Stage);
+
+		//Only the stages whose parameters changed since an earlier request run, the others are reused(finished or not).
+		//None of them is needed if the whole result was found in the result cache.
+		if (Node.bStageEntry && !bResultCached)
+		{
+			bStageFound[StageIndex] = FindStage(NodeIndex);
+		}
+
+		if (Node.bStageOutput)
+		{
+			const bool bLaunched = !bResultCached && !bStageFound[StageIndex];
+
+			if (NodeIndex == WavefrontNode)
+			{
+				if (bLaunched)
+				{
+					LaunchWavefront(NodeIndex);
+				}
+
+				//The wavefront holds the vertical pass result itself until its last band is done, the horizontal pass node never runs.
+				ReleaseReads(NodeIndex);
+			}
+
+			//Added right after it was launched, so later requests can reuse it while it is still running.
+			if (bLaunched)
+			{
+				AddStage(*Node.Stage, NodeIndex);
+			}
+
+			StageEvents[StageIndex]->Trigger();
+		}
+	}
+}
+
+void FFilterPipelineRequest::LaunchWavefront(int32 InNodeIndex)
+{
+	const FFilterPipelineGraph::FNode& Node = Graph.GetNodes()[InNodeIndex];
+	const TConstArrayView<FFilterPipelineGraph::FResource> Resources = Graph.GetResources();
+
+	Timings[InNodeIndex].StartTime = FPlatformTime::Seconds();
+
+	UE::Tasks::FTask WavefrontTask = LaunchWavefrontFilter(SourceImage, SourceHash,
+		Buffers[Resources[Node.Reads[0]].Slot].ToSharedRef(), Buffers[Resources[Node.Write].Slot].ToSharedRef(),
+		Parameters.FilterType, Parameters.FilterSize, GetNodeToken(InNodeIndex), Parameters.QoS);
+
+	//The wavefront goes wide as a whole. Its end is recorded by a continuation the readers wait for instead.
+	if (!ProfileName.IsEmpty())
+	{
+		WavefrontTask = UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[Request = AsShared(), InNodeIndex]()
+			{
+				Request->Timings[InNodeIndex].EndTime = FPlatformTime::Seconds();
+			},
+			UE::Tasks::Prerequisites(WavefrontTask),
+			LowLevelTasks::ETaskPriority::High,
+			UE::Tasks::EExtendedTaskPriority::Inline
+		);
+	}
+
+	StageEvents[int32(*Node.Stage)]->AddPrerequisites(WavefrontTask);
+}
+
+bool FFilterPipelineRequest::FindStage(int32 InEntryNodeIndex)
+{
+	const FFilterPipelineGraph::FNode& EntryNode = Graph.GetNodes()[InEntryNodeIndex];
+	const EPipelineStage Stage = *EntryNode.Stage;
+
+	TOptional<FPipelineStageResult> CachedStage = SourceHash ? FPipelineStageCache::Get().Find(MakeStageKey(Stage), Parameters.QoS.Class) : TOptional<FPipelineStageResult>();
+
+	if (!CachedStage)
+	{
+		return false;
+	}
+
+	Cancellation->AddStage(*CachedStage);
+
+	//The nodes of the stage skip their work(they release their reads when they run), the readers of its output wait for the cached stage.
+	Buffers[Graph.GetResources()[Graph.GetNodes()[EntryNode.StageOutput].Write].Slot] = CachedStage->Image;
+	StageEvents[int32(Stage)]->AddPrerequisites(CachedStage->Task);
+
+	return true;
+}
+
+void FFilterPipelineRequest::AddStage(EPipelineStage InStage, int32 InOutputNodeIndex)
+{
+	const int32 Slot = Graph.GetResources()[Graph.GetNodes()[InOutputNodeIndex].Write].Slot;
+
+	//Later requests wait for the stage event, they can reuse the stage while it is still running.
+	const FPipelineStageResult Result{ Buffers[Slot].ToSharedRef(), *StageEvents[int32(InStage)], StageCancellations[int32(InStage)].ToSharedRef(), Parameters.QoS.Class };
+
+	if (SourceHash)
+	{
+		FPipelineStageCache::Get().Add(MakeStageKey(InStage), Result);
+	}
+	Cancellation->AddStage(Result);
+}
+
+FPipelineStageKey FFilterPipelineRequest::MakeStageKey(EPipelineStage InStage) const
+{
+	switch (InStage)
+	{
+	case EPipelineStage::Blur:
+		return MakeBlurStageKey(*SourceHash, Parameters.FilterType, Parameters.FilterSize, Parameters.IntermediatePrecision, false);
+	case EPipelineStage::ScaleAlpha:
+		return MakeScaleAlphaStageKey(*SourceHash, Parameters.ScaleValue);
+	default:
+		checkNoEntry();
+		return FPipelineStageKey();
+	}
+}
+
+FTaskImage FFilterPipelineRequest::GetResourceImage(int32 InResourceIndex) const
+{
+	const FFilterPipelineGraph::FResource& Resource = Graph.GetResources()[InResourceIndex];
+
+	switch (Resource.Type)
+	{
+	case EFilterPipelineResource::Source:
+		return FTaskImage(SourceImage);
+	case EFilterPipelineResource::ResultTexture:
+		return FTaskImage(CompositeTexture);
+	default:
+		return FTaskImage(Buffers[Resource.Slot].ToSharedRef());
+	}
+}
+
+const FCancellationTokenPtr& FFilterPipelineRequest::GetNodeToken(int32 InNodeIndex) const
+{
+	const TOptional<EPipelineStage>& Stage = Graph.GetNodes()[InNodeIndex].Stage;
+
+	//Stage nodes are canceled with their stage, which may outlive the request.
+	return Stage ? StageCancellations[int32(*Stage)]->GetToken() : Cancellation->GetToken();
+}
@@ -0,0 +1,116 @@
+#include "FilterPipelineProfile.h"
+#include "FilterPipelineGraph.h"
+#include "Logging/StructuredLog.h"
+
+static TAutoConsoleVariable<bool> CVarPipelineProfile(
+	TEXT("ThreadingSample.Pipeline.Profile"),
+	false,
+	TEXT("Records when and where every node of a texture filter request runs, logs the critical path, worker idle time and game thread wait time of every request ")
+	TEXT("and marks it as an Unreal Insights region."),
+	ECVF_Default);
+
+bool IsFilterPipelineProfilingEnabled()
+{
+	return CVarPipelineProfile.GetValueOnAnyThread();
+}
+
+FFilterPipelineProfile AnalyzeFilterPipelineRun(const FFilterPipelineGraph& InGraph, double InLaunchTime, TConstArrayView<FFilterPipelineNodeTiming> InTimings)
+{
+	const TConstArrayView<FFilterPipelineGraph::FNode> Nodes = InGraph.GetNodes();
+	check(InTimings.Num() >= Nodes.Num() && InTimings[Nodes.Num() - 1].IsRecorded());
+
+	const int32 FinalizeNode = Nodes.Num() - 1;
+
+	FFilterPipelineProfile Profile;
+	Profile.TotalTime = InTimings[FinalizeNode].EndTime - InLaunchTime;
+
+	//The dependency of InNodeIndex that finished last, INDEX_NONE if it only waited for the launch(or for nodes that were not recorded).
+	auto FindLastDependency = [&](int32 InNodeIndex)
+		{
+			int32 LastDependency = INDEX_NONE;
+			for (uint32 Dependencies = Nodes[InNodeIndex].DependencyMask; Dependencies; Dependencies &= Dependencies - 1)
+			{
+				const int32 Dependency = FMath::CountTrailingZeros(Dependencies);
+				if (InTimings[Dependency].IsRecorded() && (LastDependency == INDEX_NONE || InTimings[Dependency].EndTime > InTimings[LastDependency].EndTime))
+				{
+					LastDependency = Dependency;
+				}
+			}
+			return LastDependency;
+		};
+
+	auto GetReadyTime = [&](int32 InNodeIndex)
+		{
+			const int32 LastDependency = FindLastDependency(InNodeIndex);
+			return LastDependency != INDEX_NONE ? FMath::Max(InTimings[LastDependency].EndTime, InLaunchTime) : InLaunchTime;
+		};
+
+	for (int32 NodeIndex = FinalizeNode; NodeIndex != INDEX_NONE; NodeIndex = FindLastDependency(NodeIndex))
+	{
+		Profile.CriticalPath.Insert(NodeIndex, 0);
+		Profile.CriticalPathRunTime += InTimings[NodeIndex].EndTime - InTimings[NodeIndex].StartTime;
+	}
+
+	Profile.GameThreadWaitTime = FMath::Max(InTimings[FinalizeNode].StartTime - GetReadyTime(FinalizeNode), 0.0);
+
+	TArray<TPair<double, double>, TInlineAllocator<8>> WorkerIntervals;
+	TArray<uint32, TInlineAllocator<8>> WorkerThreads;
+
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); ++NodeIndex)
+	{
+		const FFilterPipelineNodeTiming& Timing = InTimings[NodeIndex];
+		if (!Timing.IsRecorded())
+		{
+			continue;
+		}
+
+		Profile.QueueTime += FMath::Max(Timing.StartTime - GetReadyTime(NodeIndex), 0.0);
+
+		if (Timing.ThreadId != GGameThreadId)
+		{
+			WorkerIntervals.Emplace(Timing.StartTime, Timing.EndTime);
+
+			if (Timing.ThreadId != 0)
+			{
+				WorkerThreads.AddUnique(Timing.ThreadId);
+			}
+		}
+	}
+
+	Profile.NumWorkerThreads = WorkerThreads.Num();
+
+	//The gaps in the union of the worker intervals.
+	WorkerIntervals.Sort([](const TPair<double, double>& A, const TPair<double, double>& B) { return A.Key < B.Key; });
+
+	double CoveredUntil = InLaunchTime;
+	for (const TPair<double, double>& Interval : WorkerIntervals)
+	{
+		Profile.WorkerIdleTime += FMath::Max(Interval.Key - CoveredUntil, 0.0);
+		CoveredUntil = FMath::Max(CoveredUntil, Interval.Value);
+	}
+
+	return Profile;
+}
+
+void LogFilterPipelineProfile(const FFilterPipelineGraph& InGraph, const FString& InName, bool InCanceled, const FFilterPipelineProfile& InProfile)
+{
+	FString CriticalPath;
+	for (int32 NodeIndex : InProfile.CriticalPath)
+	{
+		CriticalPath += CriticalPath.IsEmpty() ? TEXT("") : TEXT(" -> ");
+		CriticalPath += EFilterPipelineNodeToString(InGraph.GetNodes()[NodeIndex].Type);
+	}
+
+	UE_LOGFMT(LogThreadingSample, Log,
+		"Filter Pipeline Profile({Name}) {Status} in {TotalTime} Seconds. Critical Path: {CriticalPath}, Running {CriticalPathRunTime} Seconds. "
+		"Queue Time: {QueueTime} Seconds, Worker Idle Time: {WorkerIdleTime} Seconds({NumWorkerThreads} Worker Threads), Game Thread Wait Time: {GameThreadWaitTime} Seconds.",
+		("Name", InName),
+		("Status", InCanceled ? TEXT("Canceled") : TEXT("Finished")),
+		("TotalTime", InProfile.TotalTime),
+		("CriticalPath", CriticalPath),
+		("CriticalPathRunTime", InProfile.CriticalPathRunTime),
+		("QueueTime", InProfile.QueueTime),
+		("WorkerIdleTime", InProfile.WorkerIdleTime),
+		("NumWorkerThreads", InProfile.NumWorkerThreads),
+		("GameThreadWaitTime", InProfile.GameThreadWaitTime));
+}
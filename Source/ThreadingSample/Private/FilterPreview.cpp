@@ -0,0 +1,110 @@
+#include "FilterPreview.h"
+#include "TextureResize.h"
+
+static TAutoConsoleVariable<int32> CVarPreviewDownsample(
+	TEXT("ThreadingSample.Preview.Downsample"),
+	4,
+	TEXT("Factor by which the source is downsampled in both dimensions for the progressive preview of a texture filter request."),
+	ECVF_Default);
+
+static int32 GetPreviewDownsample()
+{
+	return FMath::Max(CVarPreviewDownsample.GetValueOnAnyThread(), 2);
+}
+
+//The kernel has to cover the same area of the image as the full resolution one, rounded to the nearest valid(odd, at least 3) size.
+static int32 GetPreviewFilterSize(int32 InFilterSize, int32 InDownsample)
+{
+	const int32 PreviewFilterSize = FMath::RoundToInt32(float(InFilterSize) / InDownsample);
+	return FMath::Max(PreviewFilterSize | 1, 3);
+}
+
+bool ShouldLaunchFilterPreview(UTexture2D* InSourceTexture)
+{
+	check(InSourceTexture);
+
+	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
+
+	return SourceMip->SizeX >= GetPreviewDownsample() && SourceMip->SizeY >= GetPreviewDownsample();
+}
+
+FFilterPreview LaunchFilterPreview(UTexture2D* InSourceTexture, FSourceImageRef InSource, EFilterType InFilterType, int32 InFilterSize, float InScaleValue,
+	FFilterRequestCancellationPtr InCancellation, const UE::Tasks::FTask& InFullResultTask)
+{
+	check(InSourceTexture && InCancellation.IsValid());
+
+	const int32 Downsample = GetPreviewDownsample();
+	const int32 PreviewSizeX = FMath::DivideAndRoundUp(InSource->GetView().SizeX, Downsample);
+	const int32 PreviewSizeY = FMath::DivideAndRoundUp(InSource->GetView().SizeY, Downsample);
+	const int32 PreviewFilterSize = GetPreviewFilterSize(InFilterSize, Downsample);
+
+	FFilterPreview OutPreview;
+	OutPreview.Texture = CreateTransientTextureWithSizeAsync(InSourceTexture, PreviewSizeX, PreviewSizeY, TEXT("PreviewResult"));
+
+	//The whole preview is small enough for one task, whose loops still go wide through ParallelFor.
+	auto PreviewTask = UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[Source = MoveTemp(InSource), Result = FTaskImage(OutPreview.Texture), InFilterType, PreviewFilterSize, InScaleValue, PreviewSizeX, PreviewSizeY,
+		Cancellation = InCancellation, FullResultTask = InFullResultTask]()
+		{
+			if (Cancellation->IsCanceled() || FullResultTask.IsCompleted() || !Result.IsAvailable())
+			{
+				return;
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+
+			const EGammaSpace GammaSpace = Source->GetView().GetGammaSpace();
+			FImageBufferRef Downsampled = FImageBufferPool::Get().Acquire(PreviewSizeX, PreviewSizeY, ERawImageFormat::BGRA8, GammaSpace);
+			FImageBufferRef VerticalPassResult = FImageBufferPool::Get().Acquire(PreviewSizeX, PreviewSizeY, ERawImageFormat::BGRA8, GammaSpace);
+			FImageBufferRef HorizontalPassResult = FImageBufferPool::Get().Acquire(PreviewSizeX, PreviewSizeY, ERawImageFormat::BGRA8, GammaSpace);
+			FImageBufferRef ScaleAlphaChannelResult = FImageBufferPool::Get().Acquire(PreviewSizeX, PreviewSizeY, ERawImageFormat::BGRA8, GammaSpace);
+
+			const FImageView DownsampledView(*Downsampled, Downsampled->RawData.GetData());
+			const FImageView VerticalPassResultView(*VerticalPassResult, VerticalPassResult->RawData.GetData());
+			const FImageView HorizontalPassResultView(*HorizontalPassResult, HorizontalPassResult->RawData.GetData());
+			const FImageView ScaleAlphaChannelResultView(*ScaleAlphaChannelResult, ScaleAlphaChannelResult->RawData.GetData());
+
+			const UE::Tasks::FCancellationToken* CancellationToken = Cancellation->GetToken().Get();
+
+			ResizeImage(Source->GetView(), DownsampledView, EResizeFilter::Mitchell, false);
+			FilterTexture(DownsampledView, VerticalPassResultView, InFilterType, PreviewFilterSize, EConvolutionType::OneDVertical, false, CancellationToken);
+			FilterTexture(VerticalPassResultView, HorizontalPassResultView, InFilterType, PreviewFilterSize, EConvolutionType::OneDHorizontal, false, CancellationToken);
+			ScaleAlphaChannel(DownsampledView, ScaleAlphaChannelResultView, InScaleValue, false, CancellationToken);
+			CompositeRGBAValue(FTaskImage(HorizontalPassResult), FTaskImage(ScaleAlphaChannelResult), Result, false, CancellationToken);
+
+			UE_LOG(LogThreadingSample, Display, TEXT("Filter Preview(%s, Preview Size: %dx%d, Filter Size: %d) Execution %s in %f Seconds."),
+				EFilterTypeToString(InFilterType),
+				PreviewSizeX, PreviewSizeY, PreviewFilterSize,
+				Cancellation->IsCanceled() ? TEXT("Canceled") : TEXT("Finished"),
+				FPlatformTime::Seconds() - StartTime);
+		},
+		UE::Tasks::Prerequisites(OutPreview.Texture),
+		LowLevelTasks::ETaskPriority::High,
+		UE::Tasks::EExtendedTaskPriority::None
+	);
+
+	//Goes through the finalize queue like the full resolution upload. Whichever of the two runs first, the preview is never shown over the full result.
+	OutPreview.UploadTask = FGameThreadFinalizeQueue::Get().Launch(
+		UE_SOURCE_LOCATION,
+		[Texture = OutPreview.Texture, bUploaded = OutPreview.bUploaded, Cancellation = MoveTemp(InCancellation), FullResultTask = InFullResultTask]() mutable
+		{
+			//The texture could not be created if the source was garbage collected.
+			UTexture2D* PreviewTexture = GetTransientTexture(Texture);
+			if (Cancellation->IsCanceled() || FullResultTask.IsCompleted() || !PreviewTexture)
+			{
+				return;
+			}
+
+			UploadTextureRegions(PreviewTexture);
+
+			*bUploaded = true;
+		},
+		PreviewTask
+	);
+
+	//Previews are interactive by definition, batch work yields to them.
+	TrackInteractiveRequest(OutPreview.UploadTask);
+
+	return OutPreview;
+}
@@ -0,0 +1,116 @@
+#include "FilterQoS.h"
+
+static TAutoConsoleVariable<float> CVarQoSBatchYieldMs(
+	TEXT("ThreadingSample.QoS.BatchYieldMs"),
+	2.0f,
+	TEXT("How long batch filter work backs off per batch of pixels(or band of rows) while interactive requests are in flight, in milliseconds. 0 disables yielding."),
+	ECVF_Default);
+
+static std::atomic<int32> NumInteractiveRequestsInFlight{ 0 };
+
+const TCHAR* EFilterQoSToString(EFilterQoS InQoS)
+{
+	const TCHAR* ConvertTable[] = {
+		TEXT("Interactive"),
+		TEXT("Normal"),
+		TEXT("Batch")
+	};
+
+	return ConvertTable[int32(InQoS)];
+}
+
+FFilterQoS FFilterQoS::Make(EFilterQoS InClass, float InDeadlineSeconds)
+{
+	FFilterQoS QoS;
+	QoS.Class = InClass;
+	QoS.Deadline = InDeadlineSeconds > 0.0f ? FPlatformTime::Seconds() + InDeadlineSeconds : 0.0;
+	QoS.WorkerBudget = FWorkerBudget::MakeRequestBudget();
+	return QoS;
+}
+
+LowLevelTasks::ETaskPriority FFilterQoS::GetTaskPriority() const
+{
+	switch (Class)
+	{
+	case EFilterQoS::Interactive:
+		return LowLevelTasks::ETaskPriority::High;
+	case EFilterQoS::Normal:
+		return LowLevelTasks::ETaskPriority::BackgroundHigh;
+	case EFilterQoS::Batch:
+		return IsPastDeadline() ? LowLevelTasks::ETaskPriority::BackgroundNormal : LowLevelTasks::ETaskPriority::BackgroundLow;
+	default:
+		check(false);
+		return LowLevelTasks::ETaskPriority::BackgroundHigh;
+	}
+}
+
+ENamedThreads::Type FFilterQoS::GetDesiredThread() const
+{
+	switch (Class)
+	{
+	case EFilterQoS::Interactive:
+		return ENamedThreads::AnyHiPriThreadHiPriTask;
+	case EFilterQoS::Normal:
+		return ENamedThreads::AnyBackgroundHiPriTask;
+	case EFilterQoS::Batch:
+		//The task graph has no priority between the two, a missed deadline changes nothing here.
+		return ENamedThreads::AnyBackgroundThreadNormalTask;
+	default:
+		check(false);
+		return ENamedThreads::AnyBackgroundHiPriTask;
+	}
+}
+
+EParallelForFlags FFilterQoS::GetParallelForFlags(bool InForceSingleThread) const
+{
+	EParallelForFlags Flags = InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+	if (Class == EFilterQoS::Batch)
+	{
+		Flags |= EParallelForFlags::BackgroundPriority;
+	}
+
+	return Flags;
+}
+
+void FFilterQoS::YieldToInteractiveWork(const UE::Tasks::FCancellationToken* InCancellationToken) const
+{
+	if (Class != EFilterQoS::Batch)
+	{
+		return;
+	}
+
+	const double YieldEndTime = FPlatformTime::Seconds() + CVarQoSBatchYieldMs.GetValueOnAnyThread() / 1000.0;
+
+	//Bounded, so batch work under a steady stream of interactive requests slows down instead of stalling.
+	while (NumInteractiveRequestsInFlight.load(std::memory_order_relaxed) > 0 && FPlatformTime::Seconds() < YieldEndTime)
+	{
+		if (InCancellationToken && InCancellationToken->IsCanceled())
+		{
+			return;
+		}
+
+		FPlatformProcess::SleepNoStats(0.0002f);
+	}
+}
+
+void TrackInteractiveRequest(const UE::Tasks::FTask& InCompletionTask)
+{
+	NumInteractiveRequestsInFlight.fetch_add(1, std::memory_order_relaxed);
+
+	UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[]()
+		{
+			NumInteractiveRequestsInFlight.fetch_sub(1, std::memory_order_relaxed);
+		},
+		UE::Tasks::Prerequisites(InCompletionTask),
+		LowLevelTasks::ETaskPriority::High,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+}
+
+int32 GetNumInteractiveRequestsInFlight()
+{
+	return NumInteractiveRequestsInFlight.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,116 @@
+#include "FilterResultCache.h"
+
+static TAutoConsoleVariable<bool> CVarResultCacheEnable(
+	TEXT("ThreadingSample.ResultCache.Enable"),
+	true,
+	TEXT("Whether the texture filter pipelines reuse the result of an earlier request with the same source pixels and parameters."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarResultCacheMaxMemoryMB(
+	TEXT("ThreadingSample.ResultCache.MaxMemoryMB"),
+	256,
+	TEXT("Memory budget of the filter result cache in MB. Results are evicted(least recently used first) while the cache exceeds it.\n")
+	TEXT("Evicted results go back to the texture pool once nothing else holds them."),
+	ECVF_Default);
+
+FFilterResultKey MakeFilterResultKey(uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InOnePass)
+{
+	FFilterResultKey Key;
+	Key.SourceHash = InSourceHash;
+	Key.FilterType = InFilterType;
+	Key.FilterSize = InFilterSize;
+	Key.ScaleValue = FMath::Clamp(InScaleValue, 0.0f, 1.0f);
+	Key.IntermediatePrecision = InIntermediatePrecision;
+	Key.bOnePass = InOnePass;
+	return Key;
+}
+
+FFilterResultCache& FFilterResultCache::Get()
+{
+	//Intentionally leaked(like the texture pool it holds leases of).
+	static FFilterResultCache* GFilterResultCache = new FFilterResultCache;
+	return *GFilterResultCache;
+}
+
+bool FFilterResultCache::IsEnabled()
+{
+	return CVarResultCacheEnable.GetValueOnAnyThread();
+}
+
+FTransientTextureRef FFilterResultCache::Find(const FFilterResultKey& InKey)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 Index = Entries.IndexOfByPredicate([&InKey](const FEntry& InEntry)
+		{
+			return InEntry.Key == InKey;
+		});
+
+	if (Index == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	//Move it to the most recently used end.
+	FEntry Entry = MoveTemp(Entries[Index]);
+	Entries.RemoveAt(Index);
+
+	FTransientTextureRef Result = Entry.Result;
+	Entries.Add(MoveTemp(Entry));
+
+	return Result;
+}
+
+void FFilterResultCache::Add(const FFilterResultKey& InKey, FTransientTextureRef InResult)
+{
+	check(InResult.IsValid() && InResult->GetTexture());
+
+	FScopeLock Lock(&CriticalSection);
+
+	//Two requests with the same key may finish one after another, keep the first result.
+	if (Entries.ContainsByPredicate([&InKey](const FEntry& InEntry) { return InEntry.Key == InKey; }))
+	{
+		return;
+	}
+
+	CachedBytes += InResult->GetKey().GetSizeInBytes();
+	Entries.Add({ InKey, MoveTemp(InResult) });
+
+	TrimLocked(int64(CVarResultCacheMaxMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+}
+
+void FFilterResultCache::Trim(int64 InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	TrimLocked(InMaxBytes);
+}
+
+void FFilterResultCache::TrimLocked(int64 InMaxBytes)
+{
+	int32 NumEvicted = 0;
+	while (CachedBytes > InMaxBytes && NumEvicted < Entries.Num())
+	{
+		CachedBytes -= Entries[NumEvicted].Result->GetKey().GetSizeInBytes();
+		++NumEvicted;
+	}
+
+	if (NumEvicted > 0)
+	{
+		//Releasing the leases under the lock is fine, returning them only takes the lock of the texture pool.
+		Entries.RemoveAt(0, NumEvicted);
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Filter result cache evicted %d results (Cached: %lld bytes, Budget: %lld bytes)."), NumEvicted, CachedBytes, InMaxBytes);
+	}
+}
+
+int64 FFilterResultCache::GetCachedBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return CachedBytes;
+}
+
+int32 FFilterResultCache::GetNumEntries() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Entries.Num();
+}
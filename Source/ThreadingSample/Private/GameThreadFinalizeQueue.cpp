@@ -0,0 +1,90 @@
+#include "GameThreadFinalizeQueue.h"
+
+static TAutoConsoleVariable<float> CVarFinalizeQueueBudgetMs(
+	TEXT("ThreadingSample.FinalizeQueue.BudgetMs"),
+	2.0f,
+	TEXT("Game thread time in milliseconds the finalize queue may spend per frame. At least one item runs every frame regardless."),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Finalize Queue Depth"), STAT_FinalizeQueueDepth, STATGROUP_ThreadingSample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Finalize Items Executed"), STAT_FinalizeItemsExecuted, STATGROUP_ThreadingSample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Finalize Items Deferred"), STAT_FinalizeItemsDeferred, STATGROUP_ThreadingSample);
+
+FGameThreadFinalizeQueue& FGameThreadFinalizeQueue::Get()
+{
+	//Intentionally leaked(like the pools), work may still be queued during shutdown.
+	static FGameThreadFinalizeQueue* GFinalizeQueue = new FGameThreadFinalizeQueue;
+	return *GFinalizeQueue;
+}
+
+FGameThreadFinalizeQueue::FGameThreadFinalizeQueue()
+{
+	//Tickable objects register themselves with the game thread.
+	check(IsInGameThread());
+}
+
+void FGameThreadFinalizeQueue::Enqueue(TUniqueFunction<void()> InWork)
+{
+	check(InWork);
+
+	QueueDepth.fetch_add(1, std::memory_order_relaxed);
+	Queue.Enqueue(MoveTemp(InWork));
+}
+
+UE::Tasks::FTask FGameThreadFinalizeQueue::Launch(const TCHAR* InDebugName, TUniqueFunction<void()> InWork, const UE::Tasks::FTask& InPrerequisite)
+{
+	UE::Tasks::FTaskEvent Finalized(InDebugName);
+
+	//Inline tasks are executed by the thread that completes their last prerequisite, no extra scheduling round trip just to queue the work.
+	UE::Tasks::Launch(
+		InDebugName,
+		[this, Work = MoveTemp(InWork), Finalized]() mutable
+		{
+			Enqueue([Work = MoveTemp(Work), Finalized]() mutable
+				{
+					Work();
+					Finalized.Trigger();
+				});
+		},
+		UE::Tasks::Prerequisites(InPrerequisite),
+		LowLevelTasks::ETaskPriority::BackgroundHigh,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+
+	return Finalized;
+}
+
+void FGameThreadFinalizeQueue::Tick(float InDeltaTime)
+{
+	const double BudgetSeconds = FMath::Max(CVarFinalizeQueueBudgetMs.GetValueOnGameThread(), 0.0f) / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	int32 NumExecuted = 0;
+
+	TUniqueFunction<void()> Work;
+	while (Queue.Dequeue(Work))
+	{
+		QueueDepth.fetch_sub(1, std::memory_order_relaxed);
+
+		Work();
+		Work.Reset();
+		++NumExecuted;
+
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	NumDeferredLastFrame = GetQueueDepth();
+	if (NumDeferredLastFrame > 0)
+	{
+		++NumDeferredFrames;
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Finalize queue ran %d items in %f ms, %d deferred to the next frame."), NumExecuted, (FPlatformTime::Seconds() - StartTime) * 1000.0, NumDeferredLastFrame);
+	}
+
+	SET_DWORD_STAT(STAT_FinalizeQueueDepth, GetQueueDepth());
+	SET_DWORD_STAT(STAT_FinalizeItemsExecuted, NumExecuted);
+	SET_DWORD_STAT(STAT_FinalizeItemsDeferred, NumDeferredLastFrame);
+}
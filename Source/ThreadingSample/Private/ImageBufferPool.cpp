@@ -0,0 +1,94 @@
+#include "ImageBufferPool.h"
+
+static TAutoConsoleVariable<int32> CVarImageBufferPoolMaxIdleMemoryMB(
+	TEXT("ThreadingSample.ImagePool.MaxIdleMemoryMB"),
+	256,
+	TEXT("Memory budget of the idle images kept by the image buffer pool in MB. Idle images are freed(least recently returned first) while they exceed it."),
+	ECVF_Default);
+
+FImageBufferPool& FImageBufferPool::Get()
+{
+	//Intentionally leaked(like the transient texture pool) so leases released during shutdown still have a pool to return to.
+	static FImageBufferPool* GImageBufferPool = new FImageBufferPool;
+	return *GImageBufferPool;
+}
+
+FImageBufferRef FImageBufferPool::Acquire(int32 InSizeX, int32 InSizeY, ERawImageFormat::Type InFormat, EGammaSpace InGammaSpace)
+{
+	check(InSizeX > 0 && InSizeY > 0);
+
+	FImage* Image = nullptr;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		//Prefer the most recently returned image, its pixels are more likely to still be in cache.
+		for (int32 Index = IdleImages.Num() - 1; Index >= 0; --Index)
+		{
+			const FImage& IdleImage = *IdleImages[Index];
+			if (IdleImage.SizeX == InSizeX && IdleImage.SizeY == InSizeY && IdleImage.Format == InFormat && IdleImage.GammaSpace == InGammaSpace)
+			{
+				IdleBytes -= IdleImage.GetImageSizeBytes();
+				Image = IdleImages[Index].Release();
+				IdleImages.RemoveAt(Index);
+				break;
+			}
+		}
+	}
+
+	if (!Image)
+	{
+		Image = new FImage;
+		Image->Init(InSizeX, InSizeY, 1, InFormat, InGammaSpace);
+	}
+
+	return MakeShareable(Image, [](FImage* InImage)
+		{
+			FImageBufferPool::Get().Return(InImage);
+		});
+}
+
+void FImageBufferPool::Return(FImage* InImage)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	IdleBytes += InImage->GetImageSizeBytes();
+	IdleImages.Emplace(InImage);
+
+	TrimLocked(int64(CVarImageBufferPoolMaxIdleMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+}
+
+void FImageBufferPool::Trim(int64 InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	TrimLocked(InMaxBytes);
+}
+
+void FImageBufferPool::TrimLocked(int64 InMaxBytes)
+{
+	int32 NumFreed = 0;
+	while (IdleBytes > InMaxBytes && NumFreed < IdleImages.Num())
+	{
+		IdleBytes -= IdleImages[NumFreed]->GetImageSizeBytes();
+		++NumFreed;
+	}
+
+	if (NumFreed > 0)
+	{
+		IdleImages.RemoveAt(0, NumFreed);
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Image buffer pool freed %d idle images (Idle: %lld bytes, Budget: %lld bytes)."), NumFreed, IdleBytes, InMaxBytes);
+	}
+}
+
+int64 FImageBufferPool::GetIdleBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return IdleBytes;
+}
+
+int32 FImageBufferPool::GetNumIdleImages() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return IdleImages.Num();
+}
@@ -0,0 +1,113 @@
+#include "LinearImageCache.h"
+
+static TAutoConsoleVariable<int32> CVarLinearImageCacheMaxMemoryMB(
+	TEXT("ThreadingSample.LinearImageCache.MaxMemoryMB"),
+	512,
+	TEXT("Memory budget of the linear source image cache in MB. Entries are evicted(least recently used first) while the cache exceeds it.\n")
+	TEXT("Evicted images stay alive until the requests reading them are done."),
+	ECVF_Default);
+
+FLinearImageCache& FLinearImageCache::Get()
+{
+	//Intentionally leaked(like the image buffer pool) so images released during shutdown never outlive the cache.
+	static FLinearImageCache* GLinearImageCache = new FLinearImageCache;
+	return *GLinearImageCache;
+}
+
+//The snapshot is held by the decode task only, the source mip is unlocked as soon as it is decoded.
+static UE::Tasks::FTask LaunchLinearDecode(const FSourceImageRef& InSource, const TSharedRef<FImage, ESPMode::ThreadSafe>& OutImage)
+{
+	return UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[InSource, OutImage]()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			InSource->GetView().CopyTo(*OutImage, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+			UE_LOG(LogThreadingSample, Display, TEXT("Decode Linear Source Image(Texture Size: %dx%d) Execution Finished in %f Seconds."),
+				OutImage->SizeX, OutImage->SizeY,
+				FPlatformTime::Seconds() - StartTime);
+		},
+		LowLevelTasks::ETaskPriority::BackgroundHigh
+	);
+}
+
+FLinearSourceImage FLinearImageCache::Acquire(const FSourceImageRef& InSource, TOptional<uint64> InSourceHash)
+{
+	const FImageView& SourceView = InSource->GetView();
+
+	TSharedRef<FImage, ESPMode::ThreadSafe> Image = MakeShared<FImage, ESPMode::ThreadSafe>();
+
+	if (!InSourceHash)
+	{
+		return { Image, LaunchLinearDecode(InSource, Image) };
+	}
+
+	const FEntryKey Key{ *InSourceHash, SourceView.GetGammaSpace(), SourceView.SizeX, SourceView.SizeY };
+
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 Index = Entries.IndexOfByPredicate([&Key](const FEntry& InEntry)
+		{
+			return InEntry.Key == Key;
+		});
+
+	if (Index != INDEX_NONE)
+	{
+		//Move it to the most recently used end.
+		FEntry Entry = MoveTemp(Entries[Index]);
+		Entries.RemoveAt(Index);
+
+		FLinearSourceImage Result{ Entry.Image, Entry.DecodeTask };
+		Entries.Add(MoveTemp(Entry));
+
+		return Result;
+	}
+
+	UE::Tasks::FTask DecodeTask = LaunchLinearDecode(InSource, Image);
+
+	const int64 SizeInBytes = int64(SourceView.SizeX) * SourceView.SizeY * sizeof(FLinearColor);
+
+	Entries.Add({ Key, Image, DecodeTask, SizeInBytes });
+	CachedBytes += SizeInBytes;
+
+	TrimLocked(int64(CVarLinearImageCacheMaxMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+
+	return { Image, DecodeTask };
+}
+
+void FLinearImageCache::Trim(int64 InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	TrimLocked(InMaxBytes);
+}
+
+void FLinearImageCache::TrimLocked(int64 InMaxBytes)
+{
+	int32 NumEvicted = 0;
+	while (CachedBytes > InMaxBytes && NumEvicted < Entries.Num())
+	{
+		CachedBytes -= Entries[NumEvicted].SizeInBytes;
+		++NumEvicted;
+	}
+
+	if (NumEvicted > 0)
+	{
+		Entries.RemoveAt(0, NumEvicted);
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Linear image cache evicted %d entries (Cached: %lld bytes, Budget: %lld bytes)."), NumEvicted, CachedBytes, InMaxBytes);
+	}
+}
+
+int64 FLinearImageCache::GetCachedBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return CachedBytes;
+}
+
+int32 FLinearImageCache::GetNumEntries() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Entries.Num();
+}
@@ -0,0 +1,277 @@
+#include "PipelineStageCache.h"
+#include "WavefrontFilter.h"
+
+static TAutoConsoleVariable<bool> CVarStageCacheEnable(
+	TEXT("ThreadingSample.StageCache.Enable"),
+	true,
+	TEXT("Whether the texture filter pipelines reuse the stage results of earlier requests whose inputs did not change."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarStageCacheMaxMemoryMB(
+	TEXT("ThreadingSample.StageCache.MaxMemoryMB"),
+	256,
+	TEXT("Memory budget of the pipeline stage cache in MB. Stage results are evicted(least recently used first) while the cache exceeds it."),
+	ECVF_Default);
+
+FPipelineStageKey MakeBlurStageKey(uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, EIntermediatePrecision InIntermediatePrecision, bool InOnePass)
+{
+	FPipelineStageKey Key;
+	Key.Stage = EPipelineStage::Blur;
+	Key.SourceHash = InSourceHash;
+	Key.FilterType = InFilterType;
+	Key.FilterSize = InFilterSize;
+	//The intermediate precision does not matter for a single 2D pass.
+	Key.IntermediatePrecision = InOnePass ? EIntermediatePrecision::EightBit : InIntermediatePrecision;
+	Key.bOnePass = InOnePass;
+	return Key;
+}
+
+FPipelineStageKey MakeScaleAlphaStageKey(uint64 InSourceHash, float InScaleValue)
+{
+	FPipelineStageKey Key;
+	Key.Stage = EPipelineStage::ScaleAlpha;
+	Key.SourceHash = InSourceHash;
+	Key.ScaleValue = FMath::Clamp(InScaleValue, 0.0f, 1.0f);
+	return Key;
+}
+
+bool FPipelineStageCancellation::TryAddUser()
+{
+	int32 CurrentUsers = NumUsers.load();
+	while (CurrentUsers > 0)
+	{
+		if (NumUsers.compare_exchange_weak(CurrentUsers, CurrentUsers + 1))
+		{
+			return true;
+		}
+	}
+
+	//The last user was released, the stage is canceled(or about to be).
+	return false;
+}
+
+void FPipelineStageCancellation::ReleaseUser()
+{
+	if (NumUsers.fetch_sub(1) == 1)
+	{
+		Token->Cancel();
+	}
+}
+
+void FFilterRequestCancellation::AddStage(const FPipelineStageResult& InStage)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (!Token->IsCanceled())
+		{
+			Stages.Add({ InStage.Task, InStage.Cancellation });
+			return;
+		}
+	}
+
+	InStage.Cancellation->ReleaseUser();
+}
+
+void FFilterRequestCancellation::Cancel()
+{
+	TArray<FStage> StagesToRelease;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (Token->IsCanceled())
+		{
+			return;
+		}
+
+		Token->Cancel();
+		StagesToRelease = MoveTemp(Stages);
+	}
+
+	for (const FStage& Stage : StagesToRelease)
+	{
+		//A completed stage is valid no matter who uses it, it stays in the stage cache.
+		if (!Stage.Task.IsCompleted())
+		{
+			Stage.Cancellation->ReleaseUser();
+		}
+	}
+}
+
+FPipelineStageCache& FPipelineStageCache::Get()
+{
+	//Intentionally leaked(like the image buffer pool its images go back to).
+	static FPipelineStageCache* GPipelineStageCache = new FPipelineStageCache;
+	return *GPipelineStageCache;
+}
+
+bool FPipelineStageCache::IsEnabled()
+{
+	return CVarStageCacheEnable.GetValueOnAnyThread();
+}
+
+TOptional<FPipelineStageResult> FPipelineStageCache::Find(const FPipelineStageKey& InKey, EFilterQoS InQoS)
+{
+	if (!IsEnabled())
+	{
+		return {};
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 Index = Entries.IndexOfByPredicate([&InKey](const FEntry& InEntry)
+		{
+			return InEntry.Key == InKey;
+		});
+
+	if (Index == INDEX_NONE)
+	{
+		return {};
+	}
+
+	//Waiting for a stage that is still running at a lower priority would drag the request down to it.
+	if (Entries[Index].Result.QoS > InQoS && !Entries[Index].Result.Task.IsCompleted())
+	{
+		return {};
+	}
+
+	//A canceled stage left its image unfinished.
+	if (!Entries[Index].Result.Cancellation->TryAddUser())
+	{
+		CachedBytes -= Entries[Index].Result.Image->GetImageSizeBytes();
+		Entries.RemoveAt(Index);
+		return {};
+	}
+
+	//Move it to the most recently used end.
+	FEntry Entry = MoveTemp(Entries[Index]);
+	Entries.RemoveAt(Index);
+
+	FPipelineStageResult Result = Entry.Result;
+	Entries.Add(MoveTemp(Entry));
+
+	return Result;
+}
+
+void FPipelineStageCache::Add(const FPipelineStageKey& InKey, const FPipelineStageResult& InResult)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 Index = Entries.IndexOfByPredicate([&InKey](const FEntry& InEntry) { return InEntry.Key == InKey; });
+
+	if (Index != INDEX_NONE)
+	{
+		if (Entries[Index].Result.QoS <= InResult.QoS)
+		{
+			return;
+		}
+
+		//Replaced by the same stage launched at a higher QoS class, the old one keeps running for the requests using it.
+		CachedBytes -= Entries[Index].Result.Image->GetImageSizeBytes();
+		Entries.RemoveAt(Index);
+	}
+
+	CachedBytes += InResult.Image->GetImageSizeBytes();
+	Entries.Add({ InKey, InResult });
+
+	TrimLocked(int64(CVarStageCacheMaxMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+}
+
+void FPipelineStageCache::Trim(int64 InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	TrimLocked(InMaxBytes);
+}
+
+void FPipelineStageCache::TrimLocked(int64 InMaxBytes)
+{
+	int32 NumEvicted = 0;
+	while (CachedBytes > InMaxBytes && NumEvicted < Entries.Num())
+	{
+		CachedBytes -= Entries[NumEvicted].Result.Image->GetImageSizeBytes();
+		++NumEvicted;
+	}
+
+	if (NumEvicted > 0)
+	{
+		//Images still read by a running request go back to the pool once that request is done with them.
+		Entries.RemoveAt(0, NumEvicted);
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Pipeline stage cache evicted %d results (Cached: %lld bytes, Budget: %lld bytes)."), NumEvicted, CachedBytes, InMaxBytes);
+	}
+}
+
+int64 FPipelineStageCache::GetCachedBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return CachedBytes;
+}
+
+int32 FPipelineStageCache::GetNumEntries() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Entries.Num();
+}
+
+FPipelineStageResult FindOrLaunchBlurStage(const FSourceImageRef& InSource, uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, EIntermediatePrecision InIntermediatePrecision, const FFilterQoS& InQoS, FFilterRequestCancellation& InRequest)
+{
+	const FPipelineStageKey Key = MakeBlurStageKey(InSourceHash, InFilterType, InFilterSize, InIntermediatePrecision, false);
+
+	if (TOptional<FPipelineStageResult> CachedResult = FPipelineStageCache::Get().Find(Key, InQoS.Class))
+	{
+		InRequest.AddStage(*CachedResult);
+		return *CachedResult;
+	}
+
+	//The vertical pass result is only read by the wavefront, it goes back to the pool once the wavefront is done with it.
+	FImageBufferRef VerticalPassResult = AcquireIntermediateImageBuffer(InSource->GetTexture(), InIntermediatePrecision);
+	FImageBufferRef HorizontalPassResult = AcquireImageBufferFromSource(InSource->GetTexture());
+
+	FPipelineStageCancellationRef Cancellation = MakeShared<FPipelineStageCancellation, ESPMode::ThreadSafe>();
+
+	const FPipelineStageResult Result{ HorizontalPassResult, LaunchWavefrontFilter(InSource, InSourceHash, VerticalPassResult, HorizontalPassResult, InFilterType, InFilterSize, Cancellation->GetToken(), InQoS), Cancellation, InQoS.Class };
+	FPipelineStageCache::Get().Add(Key, Result);
+	InRequest.AddStage(Result);
+
+	return Result;
+}
+
+FPipelineStageResult FindOrLaunchScaleAlphaStage(const FSourceImageRef& InSource, uint64 InSourceHash, float InScaleValue, const FFilterQoS& InQoS, FFilterRequestCancellation& InRequest)
+{
+	const FPipelineStageKey Key = MakeScaleAlphaStageKey(InSourceHash, InScaleValue);
+
+	if (TOptional<FPipelineStageResult> CachedResult = FPipelineStageCache::Get().Find(Key, InQoS.Class))
+	{
+		InRequest.AddStage(*CachedResult);
+		return *CachedResult;
+	}
+
+	FImageBufferRef ScaleAlphaChannelResult = AcquireImageBufferFromSource(InSource->GetTexture());
+	FPipelineStageCancellationRef Cancellation = MakeShared<FPipelineStageCancellation, ESPMode::ThreadSafe>();
+
+	auto ScaleAlphaChannelTask = UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[SourceTexture = FTaskImage(InSource),
+		ScaledResult = FTaskImage(ScaleAlphaChannelResult),
+		InScaleValue,
+		CancellationToken = Cancellation->GetToken(),
+		InQoS]()
+		{
+			ScaleAlphaChannel(SourceTexture, ScaledResult, InScaleValue, false, CancellationToken.Get(), InQoS);
+		},
+		InQoS.GetTaskPriority(),
+		UE::Tasks::EExtendedTaskPriority::None
+	);
+
+	const FPipelineStageResult Result{ ScaleAlphaChannelResult, ScaleAlphaChannelTask, Cancellation, InQoS.Class };
+	FPipelineStageCache::Get().Add(Key, Result);
+	InRequest.AddStage(Result);
+
+	return Result;
+}
@@ -0,0 +1,88 @@
+#include "SourceImageSnapshot.h"
+
+#include "Engine/Texture2D.h"
+
+FSourceImageSnapshot::~FSourceImageSnapshot()
+{
+	FSourceImageSnapshotRegistry::Get().Release(Texture);
+}
+
+FSourceImageRef AcquireSourceImageSnapshot(UTexture2D* InSourceTexture)
+{
+	return FSourceImageSnapshotRegistry::Get().Acquire(InSourceTexture);
+}
+
+FSourceImageSnapshotRegistry& FSourceImageSnapshotRegistry::Get()
+{
+	//Intentionally leaked(like the texture pool) so snapshots released during shutdown still have a registry to go back to.
+	static FSourceImageSnapshotRegistry* GSourceImageSnapshotRegistry = new FSourceImageSnapshotRegistry;
+	return *GSourceImageSnapshotRegistry;
+}
+
+FSourceImageRef FSourceImageSnapshotRegistry::Acquire(UTexture2D* InTexture)
+{
+	check(InTexture && InTexture->GetPixelFormat() == PF_B8G8R8A8);
+
+	//Only a handful of textures are read at once, a linear search is fine.
+	FScopeLock Lock(&CriticalSection);
+
+	FLockedTexture* LockedTexture = LockedTextures.FindByPredicate([InTexture](const FLockedTexture& InLockedTexture)
+		{
+			return InLockedTexture.Texture == InTexture;
+		});
+
+	if (!LockedTexture)
+	{
+		FTexture2DMipMap* Mip = &InTexture->GetPlatformData()->Mips[0];
+
+		LockedTexture = &LockedTextures.AddDefaulted_GetRef();
+		LockedTexture->Texture = InTexture;
+		LockedTexture->BulkData = &Mip->BulkData;
+
+		void* ColorData = LockedTexture->BulkData->Lock(LOCK_READ_ONLY);
+		check(ColorData);
+
+		LockedTexture->View = FImageView(ColorData, Mip->SizeX, Mip->SizeY, 1, ERawImageFormat::BGRA8, InTexture->SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear);
+	}
+
+	++LockedTexture->NumSnapshots;
+
+	return MakeShareable(new FSourceImageSnapshot(InTexture, LockedTexture->View));
+}
+
+void FSourceImageSnapshotRegistry::Release(UTexture2D* InTexture)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 Index = LockedTextures.IndexOfByPredicate([InTexture](const FLockedTexture& InLockedTexture)
+		{
+			return InLockedTexture.Texture == InTexture;
+		});
+	check(Index != INDEX_NONE);
+
+	FLockedTexture& LockedTexture = LockedTextures[Index];
+
+	//Unlocking under the registry lock, so a new snapshot of the same texture can never lock the mip before it is unlocked.
+	if (--LockedTexture.NumSnapshots == 0)
+	{
+		LockedTexture.BulkData->Unlock();
+		LockedTextures.RemoveAtSwap(Index);
+	}
+}
+
+int32 FSourceImageSnapshotRegistry::GetNumLockedTextures() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return LockedTextures.Num();
+}
+
+void FSourceImageSnapshotRegistry::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	//Snapshots can be released from worker threads while GC gathers references.
+	FScopeLock Lock(&CriticalSection);
+
+	for (FLockedTexture& LockedTexture : LockedTextures)
+	{
+		Collector.AddReferencedObject(LockedTexture.Texture);
+	}
+}
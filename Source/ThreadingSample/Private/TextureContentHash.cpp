@@ -0,0 +1,98 @@
+#include "TextureContentHash.h"
+
+#include "Async/ParallelFor.h"
+#include "Hash/xxhash.h"
+#include "Misc/MemStack.h"
+
+//Bytes hashed by one loop body or task. Big enough to amortize the scheduling, small enough to balance a 4K image over the workers.
+//Changing it changes every hash.
+static constexpr int64 ContentHashChunkSize = 1024 * 1024;
+
+static int32 GetNumContentHashChunks(const FImageView& InImage)
+{
+	return int32(FMath::DivideAndRoundUp(InImage.GetImageSizeBytes(), ContentHashChunkSize));
+}
+
+static uint64 HashContentChunk(const FImageView& InImage, int32 InChunkIndex)
+{
+	const int64 Offset = InChunkIndex * ContentHashChunkSize;
+	const int64 NumBytes = FMath::Min(ContentHashChunkSize, InImage.GetImageSizeBytes() - Offset);
+
+	return FXxHash64::HashBuffer(static_cast<const uint8*>(InImage.RawData) + Offset, NumBytes).Hash;
+}
+
+static uint64 CombineContentChunkHashes(const FImageView& InImage, TConstArrayView<uint64> InChunkHashes)
+{
+	const uint64 ChunksHash = FXxHash64::HashBuffer(InChunkHashes.GetData(), InChunkHashes.Num() * sizeof(uint64)).Hash;
+
+	const uint64 Description[] = { ChunksHash, uint64(InImage.SizeX), uint64(InImage.SizeY), uint64(InImage.NumSlices), uint64(InImage.Format), uint64(InImage.GammaSpace) };
+	return FXxHash64::HashBuffer(Description, sizeof(Description)).Hash;
+}
+
+uint64 ComputeImageContentHash(const FImageView& InImage, bool InForceSingleThread)
+{
+	check(InImage.RawData || InImage.GetImageSizeBytes() == 0);
+
+	const int32 NumChunks = GetNumContentHashChunks(InImage);
+
+	FMemMark Mark(FMemStack::Get());
+
+	TArray<uint64, TMemStackAllocator<>> ChunkHashes;
+	ChunkHashes.SetNumUninitialized(NumChunks);
+
+	ParallelFor(
+		TEXT("Parallel Content Hash"),
+		NumChunks,
+		1,
+		[&InImage, &ChunkHashes](int32 ChunkIndex) {
+			ChunkHashes[ChunkIndex] = HashContentChunk(InImage, ChunkIndex);
+		},
+		InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	return CombineContentChunkHashes(InImage, ChunkHashes);
+}
+
+UE::Tasks::TTask<uint64> LaunchImageContentHash(FSourceImageRef InSource)
+{
+	const int32 NumChunks = GetNumContentHashChunks(InSource->GetView());
+
+	//Written by the chunk tasks, every one its own element.
+	TSharedRef<TArray<uint64>, ESPMode::ThreadSafe> ChunkHashes = MakeShared<TArray<uint64>, ESPMode::ThreadSafe>();
+	ChunkHashes->SetNumUninitialized(NumChunks);
+
+	FMemMark Mark(FMemStack::Get());
+
+	TArray<UE::Tasks::FTask, TMemStackAllocator<>> ChunkTasks;
+	ChunkTasks.Reserve(NumChunks);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		ChunkTasks.Add(UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[InSource, ChunkHashes, ChunkIndex]()
+			{
+				(*ChunkHashes)[ChunkIndex] = HashContentChunk(InSource->GetView(), ChunkIndex);
+			},
+			LowLevelTasks::ETaskPriority::BackgroundHigh,
+			UE::Tasks::EExtendedTaskPriority::None
+		));
+	}
+
+	//Combines the chunk hashes, executed by whichever worker completes the last chunk.
+	return UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[InSource, ChunkHashes]()
+		{
+			return CombineContentChunkHashes(InSource->GetView(), *ChunkHashes);
+		},
+		UE::Tasks::Prerequisites(ChunkTasks),
+		LowLevelTasks::ETaskPriority::BackgroundHigh,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+}
+
+uint64 ComputeTextureContentHash(UTexture2D* InTexture)
+{
+	FSourceImageRef Source = AcquireSourceImageSnapshot(InTexture);
+	return ComputeImageContentHash(Source->GetView());
+}
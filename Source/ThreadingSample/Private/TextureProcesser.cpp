@@ -2,169 +2,116 @@
 
 ATaskTextureFilter::ATaskTextureFilter()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	//Results are broadcasted by the game thread finalize queue, nothing to poll.
+	PrimaryActorTick.bCanEverTick = false;
 }
 
-void ATaskTextureFilter::Tick(float InDeltaTime)
+void ATaskTextureFilter::FinishProcessing(FTransientTextureRef InResult, uint32 InRequestSerial)
 {
-	Super::Tick(InDeltaTime);
+	//The request was canceled, a newer one may be in flight already.
+	if (InRequestSerial != RequestSerial)
+	{
+		return;
+	}
 
-	//Check task status and broadcast if completed
-	if (IsCompleted())
+	//Null if the source was garbage collected while the request was running, there is nothing to broadcast then.
+	//Blueprints may keep showing the broadcasted texture, so it never goes back to the pool(also when it came from the result cache).
+	if (InResult.IsValid() && OnProcessFinished.IsBound())
 	{
-		if (OnProcessFinished.IsBound())
-		{
-			OnProcessFinished.Broadcast(ProcessedResult);
-			OnProcessFinished.Clear();
-		}
+		InResult->MarkExposed();
+		OnProcessFinished.Broadcast(InResult->GetTexture());
+		OnProcessFinished.Clear();
+	}
 
-		if (ProcessedResult)
-		{
-			ProcessedResult = nullptr;
-		}
+	ProcessedResult = FTransientTextureTask{};
+	Task = UE::Tasks::FTask{};
+	Cancellation = nullptr;
+	bRequestInFlight = false;
 
-		if (Task.IsValid())
-		{
-			Task = UE::Tasks::FTask{};
-		}
+	//The request that came in while this one was running, if any.
+	LaunchPendingRequest();
+}
+
+void ATaskTextureFilter::CancelRunningRequest()
+{
+	if (Cancellation.IsValid())
+	{
+		Cancellation->Cancel();
+		Cancellation = nullptr;
 	}
+
+	//Releases the leased texture of the canceled request(once its tasks are done with it).
+	ProcessedResult = FTransientTextureTask{};
+	Task = UE::Tasks::FTask{};
+	bRequestInFlight = false;
 }
 
-//TODO:Dont Repeat Yourself
 void ATaskTextureFilter::StartProcessing(UTexture2D* InSourceTexture)
 {
 	if (InSourceTexture)
 	{
-		if (!ValidateParameters(InSourceTexture, FilterSize, ScaleValue))
+		//Latest wins: at most one pipeline is in flight and at most one request waits for it.
+		//A newer request replaces the waiting one, so dragging a slider never queues more than one stale pipeline.
+		if (bRequestInFlight)
 		{
-			ProcessedResult = nullptr;
-			Task = UE::Tasks::FTask{};
-
-			if (OnProcessFinished.IsBound())
-			{
-				OnProcessFinished.Broadcast(nullptr);
-				OnProcessFinished.Clear();
-			}
-
+			PendingSourceTexture = InSourceTexture;
 			return;
 		}
 
-		UTexture2D* VerticalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("VerticalPassResult"));
-		UTexture2D* HorizontalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("HorizontalPassResult"));
-		//We need ScaleAlphaChannelInput here because the first filter task and scale alpha channel task could overlap their execution.
-		//The calling of Lock() and Unlock() could assert in such case if we pass InSourceTexture to both tasks.
-		//We just duplicate InSourceTexture to another texture which we pass to scale alpha channel task for simplicity.
-		UTexture2D* ScaleAlphaChannelInput = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelInput"), true);
-		UTexture2D* ScaleAlphaChannelResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelResult"));
-		UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
-
-		auto VerticalPassTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[SourceTexture = TWeakObjectPtr<UTexture2D>(InSourceTexture),
-			FilteredResult = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-			FilterType = this->FilterType, FilterSize = this->FilterSize]()
-			{
-				FilterTexture(SourceTexture, FilteredResult, FilterType, FilterSize, EConvolutionType::OneDVertical, false);
-			},
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::None
-		);
-
-		auto VerticalPassResultUpdateTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[TextureToUpdate = TWeakObjectPtr<UTexture2D>(VerticalPassResult)]()
-			{
-				TextureToUpdate->UpdateResource();
-			},
-			UE::Tasks::Prerequisites(VerticalPassTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-		);
-
-		auto HorizontalPassTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[SourceTexture = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-			FilteredResult = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-			FilterType = this->FilterType, FilterSize = this->FilterSize]()
-			{
-				FilterTexture(SourceTexture, FilteredResult, FilterType, FilterSize, EConvolutionType::OneDHorizontal, false);
-			},
-			UE::Tasks::Prerequisites(VerticalPassResultUpdateTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::None
-		);
-
-		auto HorizontalPassResultUpdateTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[TextureToUpdate = TWeakObjectPtr<UTexture2D>(HorizontalPassResult)]()
-			{
-				TextureToUpdate->UpdateResource();
-			},
-			UE::Tasks::Prerequisites(HorizontalPassTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-		);
-
-		auto ScaleAlphaChannelTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[SourceTexture = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelInput),
-			ScaledResult = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-			ScaleValue = this->ScaleValue]()
-			{
-				ScaleAlphaChannel(SourceTexture, ScaledResult, ScaleValue, false);
-			},
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::None
-		);
-
-		auto ScaleAlphaChannelResultUpdateTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[TextureToUpdate = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult)]()
-			{
-				TextureToUpdate->UpdateResource();
-			},
-			UE::Tasks::Prerequisites(ScaleAlphaChannelTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-		);
-
-		auto CompositeTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[RGBTexture = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-			AlphaTexture = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-			Result = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
-			{
-				CompositeRGBAValue(RGBTexture, AlphaTexture, Result, false);
-			},
-			UE::Tasks::Prerequisites(HorizontalPassResultUpdateTask, ScaleAlphaChannelResultUpdateTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::None
-		);
-
-		auto CompositeResultUpdateTask = UE::Tasks::Launch(
-			UE_SOURCE_LOCATION,
-			[TextureToUpdate = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
-			{
-				TextureToUpdate->UpdateResource();
-			},
-			UE::Tasks::Prerequisites(CompositeTask),
-			LowLevelTasks::ETaskPriority::BackgroundHigh,
-			UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-		);
-
-		ProcessedResult = CompositeResult;
-		Task = CompositeResultUpdateTask;
+		LaunchRequest(InSourceTexture);
 	}
 }
 
-bool ATaskTextureFilter::IsCompleted() const
+void ATaskTextureFilter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (Task.IsValid())
+	PendingSourceTexture = nullptr;
+	CancelRunningRequest();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATaskTextureFilter::LaunchPendingRequest()
+{
+	check(!bRequestInFlight);
+
+	if (UTexture2D* SourceTexture = PendingSourceTexture)
 	{
-		return Task.IsCompleted();
+		PendingSourceTexture = nullptr;
+
+		//Uses the parameters at the time it is launched, not at the time it was requested.
+		LaunchRequest(SourceTexture);
 	}
-	else
+}
+
+void ATaskTextureFilter::LaunchRequest(UTexture2D* InSourceTexture)
+{
+	++RequestSerial;
+
+	if (!ValidateParameters(InSourceTexture, FilterSize, ScaleValue))
 	{
-		return false;
+		if (OnProcessFinished.IsBound())
+		{
+			OnProcessFinished.Broadcast(nullptr);
+			OnProcessFinished.Clear();
+		}
+
+		//Nothing was launched, the pending request(if any) can go right away.
+		LaunchPendingRequest();
+		return;
 	}
+
+	//The same pipeline graph as the async Blueprint functions.
+	FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture,
+		{ FilterType, FilterSize, ScaleValue, IntermediatePrecision, FFilterQoS::Make(QoS, DeadlineSeconds) });
+
+	bRequestInFlight = true;
+
+	//Identical requests reuse the cached texture and changing only the scale value reuses the last blur(and changing only the filter reuses the last scaled alpha),
+	//both caches are looked up by tasks once the source is hashed. The result is broadcasted from the finalize node, unless the request was canceled or this actor is gone by then.
+	Request->OnFinalized.BindUObject(this, &ATaskTextureFilter::FinishProcessing, RequestSerial);
+	Request->Launch(EFilterPipelineBackend::Tasks);
+
+	Cancellation = Request->GetCancellation();
+	ProcessedResult = Request->GetResult();
+	Task = Request->GetCompletionTask();
 }
@@ -1,7 +1,9 @@
 #include "TextureProcessing.h"
 
-#include "Math/GuardedInt.h"
-#include "AssetCompilingManager.h"
+
+#if WITH_EDITOR
+#include "TextureCompiler.h"
+#endif
 
 const TCHAR* EFilterTypeToString(EFilterType InFilterType)
 {
@@ -24,7 +26,18 @@ const TCHAR* EConvolutionTypeToString(EConvolutionType InConvolutionType)
 	return ConvertTable[int32(InConvolutionType)];
 }
 
-void ComputeBoxFilterKernel(int32 InFilterSize, EConvolutionType InConvolutionType, TArray<float>& OutWeights, TArray<FIntPoint>& OutOffsets)
+const TCHAR* EIntermediatePrecisionToString(EIntermediatePrecision InIntermediatePrecision)
+{
+	const TCHAR* ConvertTable[] = {
+		TEXT("EightBit"),
+		TEXT("Half"),
+		TEXT("Float")
+	};
+
+	return ConvertTable[int32(InIntermediatePrecision)];
+}
+
+void ComputeBoxFilterKernel(int32 InFilterSize, EConvolutionType InConvolutionType, FFilterWeights& OutWeights, FFilterOffsets& OutOffsets)
 {
 	const int32 HalfSize = InFilterSize / 2;
 
@@ -60,7 +73,7 @@ void ComputeBoxFilterKernel(int32 InFilterSize, EConvolutionType InConvolutionTy
 	}
 }
 
-void ComputeGaussianFilterKernel(int32 InFilterSize, EConvolutionType InConvolutionType, TArray<float>& OutWeights, TArray<FIntPoint>& OutOffsets)
+void ComputeGaussianFilterKernel(int32 InFilterSize, EConvolutionType InConvolutionType, FFilterWeights& OutWeights, FFilterOffsets& OutOffsets)
 {
 	const int32 HalfSize = InFilterSize / 2;
 
@@ -114,7 +127,7 @@ void ComputeGaussianFilterKernel(int32 InFilterSize, EConvolutionType InConvolut
 	}
 }
 
-void ComputeFilterKernel(EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, TArray<float>& OutWeights, TArray<FIntPoint>& OutOffsets)
+void ComputeFilterKernel(EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, FFilterWeights& OutWeights, FFilterOffsets& OutOffsets)
 {
 	OutWeights.Empty();
 	OutOffsets.Empty();
@@ -144,194 +157,369 @@ void ComputeFilterKernel(EFilterType InFilterType, int32 InFilterSize, EConvolut
 	check(OutWeights.Num() % 2 == 1);
 }
 
-void FilterTexture(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutFilteredTexture, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread)
+//Reads a pixel in linear space. 8 bit pixels are decoded per tap, half and float pixels are always linear.
+static FORCEINLINE FLinearColor LoadLinearPixel(const FColor& InColor, bool InIsSRGB)
 {
-	check(InSourceTexture.Get() && OutFilteredTexture.Get());
-	check(InSourceTexture->SRGB == OutFilteredTexture->SRGB);
+	if (InIsSRGB)
+	{
+		//Convert to linear space.
+		return FLinearColor(InColor);
+	}
 
-	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* SourceRawImageData = &SourceMip->BulkData;
-	FColor* SourceColorData = static_cast<FColor*>(SourceRawImageData->Lock(LOCK_READ_ONLY));
-	check(SourceColorData);
+	//Already in linear space?
+	return FLinearColor(InColor.R / 255.0f, InColor.G / 255.0f, InColor.B / 255.0f, InColor.A / 255.0f);
+}
 
-	FTexture2DMipMap* FilteredMip = &OutFilteredTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* FilteredRawImageData = &FilteredMip->BulkData;
-	FColor* FilteredColorData = static_cast<FColor*>(FilteredRawImageData->Lock(LOCK_READ_WRITE));
-	check(FilteredColorData);
+static FORCEINLINE FLinearColor LoadLinearPixel(const FFloat16Color& InColor, bool InIsSRGB)
+{
+	//4 halfs at once(F16C where the platform has it).
+	FLinearColor LinearColor;
+	VectorStore(VectorLoadHalf(&InColor.R.Encoded), &LinearColor.R);
+	return LinearColor;
+}
 
-	check(SourceMip->SizeX == FilteredMip->SizeX && SourceMip->SizeY == FilteredMip->SizeY);
+static FORCEINLINE FLinearColor LoadLinearPixel(const FLinearColor& InColor, bool InIsSRGB)
+{
+	return InColor;
+}
 
-	const uint16 TextureWidth = SourceMip->SizeX;
-	const uint16 TextureHeight = SourceMip->SizeY;
+//Writes a linear space pixel. Only 8 bit pixels are sRGB encoded.
+static FORCEINLINE void StoreLinearPixel(FColor& OutColor, const FLinearColor& InColor, bool InIsSRGB)
+{
+	OutColor = InColor.ToFColor(InIsSRGB);
+}
 
-	const bool IsSRGB = InSourceTexture->SRGB;
+static FORCEINLINE void StoreLinearPixel(FFloat16Color& OutColor, const FLinearColor& InColor, bool InIsSRGB)
+{
+	VectorStoreHalf(&OutColor.R.Encoded, VectorLoad(&InColor.R));
+}
 
-	TArray<float> Weights;
-	TArray<FIntPoint> Offsets;
+static FORCEINLINE void StoreLinearPixel(FLinearColor& OutColor, const FLinearColor& InColor, bool InIsSRGB)
+{
+	OutColor = InColor;
+}
 
-	ComputeFilterKernel(InFilterType, InFilterSize, InConvolutionType, Weights, Offsets);
+//Filters the RGB channels of one pixel in linear space, alpha is taken over from the source.
+template<typename SourcePixelType>
+static FORCEINLINE FLinearColor FilterPixel(const SourcePixelType* InSourceData, int32 InTextureWidth, int32 InTextureHeight, int32 InPixelPosX, int32 InPixelPosY, TConstArrayView<float> InWeights, TConstArrayView<FIntPoint> InOffsets, bool InIsSRGB)
+{
+	float WeightedLinearSumR = 0.0f, WeightedLinearSumG = 0.0f, WeightedLinearSumB = 0.0f;
 
-	if (Weights.Num() == 0 || Offsets.Num() == 0)
+	for (int i = 0; i < InWeights.Num(); ++i)
 	{
-		UE_LOG(LogThreadingSample, Warning, TEXT("Empty filter weights or offsets."));
-		return;
+		FIntPoint SamplePosition;
+
+		SamplePosition.X = FMath::Clamp(InPixelPosX + InOffsets[i].X, 0, InTextureWidth - 1);
+		SamplePosition.Y = FMath::Clamp(InPixelPosY + InOffsets[i].Y, 0, InTextureHeight - 1);
+
+		const FLinearColor LinearColor = LoadLinearPixel(InSourceData[SamplePosition.Y * InTextureWidth + SamplePosition.X], InIsSRGB);
+		WeightedLinearSumR += LinearColor.R * InWeights[i];
+		WeightedLinearSumG += LinearColor.G * InWeights[i];
+		WeightedLinearSumB += LinearColor.B * InWeights[i];
 	}
 
-	auto LoopBody = [=](int32 Index) {
-		const int32 CurrentPixelPosX = Index % TextureWidth;
-		const int32 CurrentPixelPosY = Index / TextureWidth;
+	const float Alpha = LoadLinearPixel(InSourceData[InPixelPosY * InTextureWidth + InPixelPosX], InIsSRGB).A;
+
+	return FLinearColor(WeightedLinearSumR, WeightedLinearSumG, WeightedLinearSumB, Alpha);
+}
+
+//The filters read and write BGRA8(sRGB or linear), RGBA16F or RGBA32F pixels. Half and float pixels have to be in linear space.
+static void CheckFilterView(const FImageView& InView)
+{
+	check(InView.Format == ERawImageFormat::BGRA8
+		|| (InView.Format == ERawImageFormat::RGBA16F || InView.Format == ERawImageFormat::RGBA32F) && InView.GammaSpace == EGammaSpace::Linear);
+}
 
-		float WeightedLinearSumR = 0.0f, WeightedLinearSumG = 0.0f, WeightedLinearSumB = 0.0f;
+static void CheckFilterViews(const FImageView& InSource, const FImageView& OutFiltered)
+{
+	CheckFilterView(InSource);
+	CheckFilterView(OutFiltered);
+	check(InSource.SizeX == OutFiltered.SizeX && InSource.SizeY == OutFiltered.SizeY);
+}
 
-		for (int i = 0; i < Weights.Num(); ++i)
+//Calls InFunctor with a default constructed source pixel and target pixel of the formats of InSource and OutFiltered,
+//so the per pixel loops are instantiated for every combination of formats instead of branching per pixel.
+template<typename FunctorType>
+static void DispatchPixelTypes(const FImageView& InSource, const FImageView& OutFiltered, FunctorType&& InFunctor)
+{
+	auto DispatchTarget = [&OutFiltered, &InFunctor](auto InSourcePixel)
 		{
-			FIntPoint SamplePosition;
+			switch (OutFiltered.Format)
+			{
+			case ERawImageFormat::RGBA16F:
+				InFunctor(InSourcePixel, FFloat16Color());
+				break;
+			case ERawImageFormat::RGBA32F:
+				InFunctor(InSourcePixel, FLinearColor());
+				break;
+			default:
+				InFunctor(InSourcePixel, FColor());
+				break;
+			}
+		};
 
-			SamplePosition.X = FMath::Clamp(CurrentPixelPosX + Offsets[i].X, 0, TextureWidth - 1);
-			SamplePosition.Y = FMath::Clamp(CurrentPixelPosY + Offsets[i].Y, 0, TextureHeight - 1);
+	switch (InSource.Format)
+	{
+	case ERawImageFormat::RGBA16F:
+		DispatchTarget(FFloat16Color());
+		break;
+	case ERawImageFormat::RGBA32F:
+		DispatchTarget(FLinearColor());
+		break;
+	default:
+		DispatchTarget(FColor());
+		break;
+	}
+}
+
+template<typename SourcePixelType, typename TargetPixelType>
+static void FilterRows(const FImageView& InSource, const FImageView& OutFiltered, TConstArrayView<float> InWeights, TConstArrayView<FIntPoint> InOffsets, int32 InFirstRow, int32 InNumRows)
+{
+	const SourcePixelType* SourceData = static_cast<const SourcePixelType*>(InSource.RawData);
+	TargetPixelType* FilteredData = static_cast<TargetPixelType*>(OutFiltered.RawData);
 
-			const FColor SampledColor = SourceColorData[SamplePosition.Y * TextureWidth + SamplePosition.X];
+	const int32 TextureWidth = InSource.SizeX;
+	const int32 TextureHeight = InSource.SizeY;
 
-			if (IsSRGB)
+	const bool DecodeSRGB = InSource.GammaSpace != EGammaSpace::Linear;
+	const bool EncodeSRGB = OutFiltered.GammaSpace != EGammaSpace::Linear;
+
+	for (int32 Y = InFirstRow; Y < InFirstRow + InNumRows; ++Y)
+	{
+		for (int32 X = 0; X < TextureWidth; ++X)
+		{
+			StoreLinearPixel(FilteredData[Y * TextureWidth + X], FilterPixel(SourceData, TextureWidth, TextureHeight, X, Y, InWeights, InOffsets, DecodeSRGB), EncodeSRGB);
+		}
+	}
+}
+
+static bool IsCanceled(const UE::Tasks::FCancellationToken* InCancellationToken)
+{
+	return InCancellationToken && InCancellationToken->IsCanceled();
+}
+
+static const TCHAR* GetExecutionResultString(const UE::Tasks::FCancellationToken* InCancellationToken)
+{
+	return IsCanceled(InCancellationToken) ? TEXT("Canceled") : TEXT("Finished");
+}
+
+//Pixels per ParallelFor batch. Cancellation is checked once per batch rather than per pixel.
+static constexpr int32 PixelsPerBatch = 8192;
+
+//Calls InLoopBody for every pixel index, batches that start after InCancellationToken is canceled are skipped.
+//Batch QoS work goes wide on the background workers and yields to interactive requests before every batch.
+//The fan-out is limited by the worker budget of the request, so its concurrent stages(and concurrent requests) split the workers.
+template<typename LoopBodyType>
+static void ParallelForPixelBatches(const TCHAR* InDebugName, int32 InNumPixels, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS, bool InForceSingleThread, const LoopBodyType& InLoopBody)
+{
+	//Returns once all loop bodies finish execution, so the caller will be blocked.
+	ParallelForWithBudget(
+		InDebugName,
+		FMath::DivideAndRoundUp(InNumPixels, PixelsPerBatch),
+		InQoS.WorkerBudget.Get(),
+		InQoS.GetTaskPriority(),
+		[&](int32 BatchIndex) {
+			InQoS.YieldToInteractiveWork(InCancellationToken);
+
+			if (IsCanceled(InCancellationToken))
 			{
-				//Convert to linear space.
-				FLinearColor LinearColor = FLinearColor(SampledColor);
-				WeightedLinearSumR += LinearColor.R * Weights[i];
-				WeightedLinearSumG += LinearColor.G * Weights[i];
-				WeightedLinearSumB += LinearColor.B * Weights[i];
+				return;
 			}
-			else
+
+			const int32 FirstPixel = BatchIndex * PixelsPerBatch;
+			const int32 EndPixel = FMath::Min(FirstPixel + PixelsPerBatch, InNumPixels);
+			for (int32 Index = FirstPixel; Index < EndPixel; ++Index)
 			{
-				//Already in linear space?
-				WeightedLinearSumR += SampledColor.R / 255.0f * Weights[i];
-				WeightedLinearSumG += SampledColor.G / 255.0f * Weights[i];
-				WeightedLinearSumB += SampledColor.B / 255.0f * Weights[i];
+				InLoopBody(Index);
 			}
-		}
+		},
+		InQoS.GetParallelForFlags(InForceSingleThread));
+}
 
-		const FColor Result = FLinearColor(WeightedLinearSumR, WeightedLinearSumG, WeightedLinearSumB).ToFColor(IsSRGB);
+template<typename SourcePixelType, typename TargetPixelType>
+static void FilterPixels(const FImageView& InSource, const FImageView& OutFiltered, TConstArrayView<float> InWeights, TConstArrayView<FIntPoint> InOffsets, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS, bool InForceSingleThread)
+{
+	const SourcePixelType* SourceData = static_cast<const SourcePixelType*>(InSource.RawData);
+	TargetPixelType* FilteredData = static_cast<TargetPixelType*>(OutFiltered.RawData);
 
-		FilteredColorData[Index] = FColor(Result.R, Result.G, Result.B, SourceColorData[Index].A);
+	const int32 TextureWidth = InSource.SizeX;
+	const int32 TextureHeight = InSource.SizeY;
+
+	const bool DecodeSRGB = InSource.GammaSpace != EGammaSpace::Linear;
+	const bool EncodeSRGB = OutFiltered.GammaSpace != EGammaSpace::Linear;
+
+	//ParallelFor blocks until all loop bodies are done, the kernel can be referenced instead of copied.
+	auto LoopBody = [SourceData, FilteredData, TextureWidth, TextureHeight, DecodeSRGB, EncodeSRGB, InWeights, InOffsets](int32 Index) {
+		StoreLinearPixel(FilteredData[Index], FilterPixel(SourceData, TextureWidth, TextureHeight, Index % TextureWidth, Index / TextureWidth, InWeights, InOffsets, DecodeSRGB), EncodeSRGB);
 		};
 
+	ParallelForPixelBatches(TEXT("Parallel Texture Filter"), TextureWidth * TextureHeight, InCancellationToken, InQoS, InForceSingleThread, LoopBody);
+}
+
+void FilterTexture(const FImageView& InSource, const FImageView& OutFiltered, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
+{
+	CheckFilterViews(InSource, OutFiltered);
+	check(InSource.RawData && OutFiltered.RawData);
+
+	const int32 TextureWidth = InSource.SizeX;
+	const int32 TextureHeight = InSource.SizeY;
+
+	//The kernel lives on the FMemStack of the calling thread and is released when this function returns.
+	FMemMark Mark(FMemStack::Get());
+
+	FFilterWeights Weights;
+	FFilterOffsets Offsets;
+
+	ComputeFilterKernel(InFilterType, InFilterSize, InConvolutionType, Weights, Offsets);
+
+	if (Weights.Num() == 0 || Offsets.Num() == 0)
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Empty filter weights or offsets."));
+		return;
+	}
+
 	const double StartTime = FPlatformTime::Seconds();
 
-	//ParallelFor will return until all loop bodies finish execution.
-	ParallelFor(
-		TEXT("Parallel Texture Filter"),
-		TextureWidth * TextureHeight,
-		8192,
-		LoopBody,
-		InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+	DispatchPixelTypes(InSource, OutFiltered, [&](auto InSourcePixel, auto InTargetPixel)
+		{
+			FilterPixels<decltype(InSourcePixel), decltype(InTargetPixel)>(InSource, OutFiltered, Weights, Offsets, InCancellationToken, InQoS, InForceSingleThread);
+		});
 
 	const double EndTime = FPlatformTime::Seconds();
 
-	UE_LOG(LogThreadingSample, Display, TEXT("%s(%s, %s, Texture Size: %dx%d, Filter Size: %d) Execution Finished in %f Seconds."),
+	UE_LOG(LogThreadingSample, Display, TEXT("%s(%s, %s, Texture Size: %dx%d, Filter Size: %d) Execution %s in %f Seconds."),
 		EFilterTypeToString(InFilterType),
 		InForceSingleThread ? TEXT("Singlethreaded") : TEXT("Multithreaded"),
 		EConvolutionTypeToString(InConvolutionType),
 		TextureWidth, TextureHeight, InFilterSize,
+		GetExecutionResultString(InCancellationToken),
 		EndTime - StartTime);
+}
+
+void FilterTexture(const FTaskImage& InSource, const FTaskImage& OutFiltered, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
+{
+	//Do not even lock the images of a canceled request(or of one whose textures are gone).
+	if (IsCanceled(InCancellationToken) || !InSource.IsAvailable() || !OutFiltered.IsAvailable())
+	{
+		return;
+	}
+
+	FScopedTaskImageAccess Source(InSource, LOCK_READ_ONLY);
+	FScopedTaskImageAccess Filtered(OutFiltered, LOCK_READ_WRITE);
 
-	FilteredRawImageData->Unlock();
-	SourceRawImageData->Unlock();
+	FilterTexture(Source.GetView(), Filtered.GetView(), InFilterType, InFilterSize, InConvolutionType, InForceSingleThread, InCancellationToken, InQoS);
 }
 
-void ScaleAlphaChannel(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutScaledTexture, float InScaleValue, bool InForceSingleThread)
+void FilterTextureRows(const FImageView& InSource, const FImageView& OutFiltered, TConstArrayView<float> InWeights, TConstArrayView<FIntPoint> InOffsets, int32 InFirstRow, int32 InNumRows)
 {
-	check(InSourceTexture.Get() && OutScaledTexture.Get());
+	CheckFilterViews(InSource, OutFiltered);
+	check(InFirstRow >= 0 && InNumRows >= 0 && InFirstRow + InNumRows <= InSource.SizeY);
 
-	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* SourceRawImageData = &SourceMip->BulkData;
-	FColor* SourceColorData = static_cast<FColor*>(SourceRawImageData->Lock(LOCK_READ_ONLY));
-	check(SourceColorData);
+	DispatchPixelTypes(InSource, OutFiltered, [&](auto InSourcePixel, auto InTargetPixel)
+		{
+			FilterRows<decltype(InSourcePixel), decltype(InTargetPixel)>(InSource, OutFiltered, InWeights, InOffsets, InFirstRow, InNumRows);
+		});
+}
 
-	FTexture2DMipMap* ScaledMip = &OutScaledTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* ScaledRawImageData = &ScaledMip->BulkData;
-	FColor* ScaledColorData = static_cast<FColor*>(ScaledRawImageData->Lock(LOCK_READ_WRITE));
-	check(ScaledColorData);
+void ScaleAlphaChannel(const FImageView& InSource, const FImageView& OutScaled, float InScaleValue, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
+{
+	check(InSource.Format == ERawImageFormat::BGRA8 && OutScaled.Format == ERawImageFormat::BGRA8);
+	check(InSource.SizeX == OutScaled.SizeX && InSource.SizeY == OutScaled.SizeY);
 
-	check(SourceMip->SizeX == ScaledMip->SizeX && SourceMip->SizeY == ScaledMip->SizeY);
+	const FColor* SourceColorData = static_cast<const FColor*>(InSource.RawData);
+	FColor* ScaledColorData = static_cast<FColor*>(OutScaled.RawData);
+	check(SourceColorData && ScaledColorData);
 
-	const uint16 TextureWidth = SourceMip->SizeX;
-	const uint16 TextureHeight = SourceMip->SizeY;
+	const int32 TextureWidth = InSource.SizeX;
+	const int32 TextureHeight = InSource.SizeY;
 
 	const double StartTime = FPlatformTime::Seconds();
 
-	//ParallelFor will return until all loop bodies finish execution, so the caller will be blocked.
-	ParallelFor(
+	ParallelForPixelBatches(
 		TEXT("Parallel Scale Alpha Channel"),
 		TextureWidth * TextureHeight,
-		8192,
+		InCancellationToken,
+		InQoS,
+		InForceSingleThread,
 		[&](int32 Index) {
 			ScaledColorData[Index].R = SourceColorData[Index].R;
 			ScaledColorData[Index].G = SourceColorData[Index].G;
 			ScaledColorData[Index].B = SourceColorData[Index].B;
 			ScaledColorData[Index].A = SourceColorData[Index].A * FMath::Clamp(InScaleValue, 0.0f, 1.0f);
-		},
-		InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+		});
 
 	const double EndTime = FPlatformTime::Seconds();
 
-	UE_LOG(LogThreadingSample, Display, TEXT("Scale Alpha Channel(%s, Texture Size: %dx%d, Scale Value: %f) Execution Finished in %f Seconds."),
+	UE_LOG(LogThreadingSample, Display, TEXT("Scale Alpha Channel(%s, Texture Size: %dx%d, Scale Value: %f) Execution %s in %f Seconds."),
 		InForceSingleThread ? TEXT("Singlethreaded") : TEXT("Multithreaded"),
 		TextureWidth, TextureHeight, InScaleValue,
+		GetExecutionResultString(InCancellationToken),
 		EndTime - StartTime);
-
-	ScaledRawImageData->Unlock();
-	SourceRawImageData->Unlock();
 }
 
-void CompositeRGBAValue(TWeakObjectPtr<UTexture2D> InRGBTexture, TWeakObjectPtr<UTexture2D> InATexture, TWeakObjectPtr<UTexture2D> OutTexture, bool InForceSingleThread)
+void ScaleAlphaChannel(const FTaskImage& InSource, const FTaskImage& OutScaled, float InScaleValue, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
 {
-	check(InRGBTexture.Get() && InATexture.Get() && OutTexture.Get());
+	if (IsCanceled(InCancellationToken) || !InSource.IsAvailable() || !OutScaled.IsAvailable())
+	{
+		return;
+	}
 
-	FTexture2DMipMap* RGBMip = &InRGBTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* RGBRawImageData = &RGBMip->BulkData;
-	FColor* RGBColorData = static_cast<FColor*>(RGBRawImageData->Lock(LOCK_READ_ONLY));
-	check(RGBColorData);
+	FScopedTaskImageAccess Source(InSource, LOCK_READ_ONLY);
+	FScopedTaskImageAccess Scaled(OutScaled, LOCK_READ_WRITE);
 
-	FTexture2DMipMap* AlphaMip = &InATexture->GetPlatformData()->Mips[0];
-	FByteBulkData* AlphaRawImageData = &AlphaMip->BulkData;
-	FColor* AlphaColorData = static_cast<FColor*>(AlphaRawImageData->Lock(LOCK_READ_ONLY));
-	check(AlphaColorData);
+	ScaleAlphaChannel(Source.GetView(), Scaled.GetView(), InScaleValue, InForceSingleThread, InCancellationToken, InQoS);
+}
 
-	FTexture2DMipMap* Result = &OutTexture->GetPlatformData()->Mips[0];
-	FByteBulkData* ResultRawImageData = &Result->BulkData;
-	FColor* ResultColorData = static_cast<FColor*>(ResultRawImageData->Lock(LOCK_READ_WRITE));
-	check(ResultColorData);
+void CompositeRGBAValue(const FImageView& InRGB, const FImageView& InA, const FImageView& Out, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
+{
+	check(InRGB.Format == ERawImageFormat::BGRA8 && InA.Format == ERawImageFormat::BGRA8 && Out.Format == ERawImageFormat::BGRA8);
+	check(InRGB.SizeX == InA.SizeX && InRGB.SizeX == Out.SizeX);
+	check(InRGB.SizeY == InA.SizeY && InRGB.SizeY == Out.SizeY);
 
-	check(RGBMip->SizeX == AlphaMip->SizeX && RGBMip->SizeX == Result->SizeX);
-	check(RGBMip->SizeY == AlphaMip->SizeY && RGBMip->SizeY == Result->SizeY);
+	const FColor* RGBColorData = static_cast<const FColor*>(InRGB.RawData);
+	const FColor* AlphaColorData = static_cast<const FColor*>(InA.RawData);
+	FColor* ResultColorData = static_cast<FColor*>(Out.RawData);
+	check(RGBColorData && AlphaColorData && ResultColorData);
 
-	const uint16 TextureWidth = RGBMip->SizeX;
-	const uint16 TextureHeight = RGBMip->SizeY;
+	const int32 TextureWidth = InRGB.SizeX;
+	const int32 TextureHeight = InRGB.SizeY;
 
 	const double StartTime = FPlatformTime::Seconds();
 
-	//ParallelFor will return until all loop bodies finish execution, so the caller will be blocked.
-	ParallelFor(
+	ParallelForPixelBatches(
 		TEXT("Parallel Composite RGBA Value"),
 		TextureWidth * TextureHeight,
-		8192,
+		InCancellationToken,
+		InQoS,
+		InForceSingleThread,
 		[&](int32 Index) {
 			ResultColorData[Index].R = RGBColorData[Index].R;
 			ResultColorData[Index].G = RGBColorData[Index].G;
 			ResultColorData[Index].B = RGBColorData[Index].B;
 			ResultColorData[Index].A = AlphaColorData[Index].A;
-		},
-		InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+		});
 
 	const double EndTime = FPlatformTime::Seconds();
 
-	UE_LOG(LogThreadingSample, Display, TEXT("Composite RGBA Value(%s, Texture Size: %dx%d) Execution Finished in %f Seconds."),
+	UE_LOG(LogThreadingSample, Display, TEXT("Composite RGBA Value(%s, Texture Size: %dx%d) Execution %s in %f Seconds."),
 		InForceSingleThread ? TEXT("Singlethreaded") : TEXT("Multithreaded"),
 		TextureWidth, TextureHeight,
+		GetExecutionResultString(InCancellationToken),
 		EndTime - StartTime);
+}
+
+void CompositeRGBAValue(const FTaskImage& InRGB, const FTaskImage& InA, const FTaskImage& Out, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken, const FFilterQoS& InQoS)
+{
+	if (IsCanceled(InCancellationToken) || !InRGB.IsAvailable() || !InA.IsAvailable() || !Out.IsAvailable())
+	{
+		return;
+	}
 
-	ResultRawImageData->Unlock();
-	AlphaRawImageData->Unlock();
-	RGBRawImageData->Unlock();
+	FScopedTaskImageAccess RGB(InRGB, LOCK_READ_ONLY);
+	FScopedTaskImageAccess Alpha(InA, LOCK_READ_ONLY);
+	FScopedTaskImageAccess Result(Out, LOCK_READ_WRITE);
+
+	CompositeRGBAValue(RGB.GetView(), Alpha.GetView(), Result.GetView(), InForceSingleThread, InCancellationToken, InQoS);
 }
 
 bool ValidateParameters(UTexture2D* InSourceTexture, int InFilterSize, float InScaleValue)
@@ -386,64 +574,216 @@ bool ValidateParameters(UTexture2D* InSourceTexture, int InFilterSize, float InS
 	return true;
 }
 
-UTexture2D* CreateTransientTextureFromSource(UTexture2D* InSourceTexture, const FString& InTextureName, bool InCopySourceImage)
+static void ApplySourceTextureSettings(UTexture2D* InSourceTexture, UTexture2D* InCreatedTexture)
+{
+	if (InSourceTexture->CompressionSettings != InCreatedTexture->CompressionSettings)
+	{
+		InCreatedTexture->CompressionSettings = InSourceTexture->CompressionSettings;
+	}
+
+#if WITH_EDITORONLY_DATA
+	if (InSourceTexture->MipGenSettings != InCreatedTexture->MipGenSettings)
+	{
+		InCreatedTexture->MipGenSettings = InSourceTexture->MipGenSettings;
+	}
+#endif
+}
+
+static FTransientTextureKey MakeTransientTextureKey(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY)
+{
+	return FTransientTextureKey(InSizeX, InSizeY, InSourceTexture->GetPixelFormat(), InSourceTexture->SRGB);
+}
+
+static FTransientTextureRef CreateTransientTextureWithSourceSettings(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY, const FString& InTextureName)
+{
+	FTransientTextureRef OutCreatedResult = FTransientTexturePool::Get().Acquire(MakeTransientTextureKey(InSourceTexture, InSizeX, InSizeY), InTextureName);
+
+	UTexture2D* CreatedTexture = OutCreatedResult->GetTexture();
+
+	ApplySourceTextureSettings(InSourceTexture, CreatedTexture);
+
+#if WITH_EDITOR
+	//Transient textures are created from platform data and normally never compile.
+	//If one does, only wait for that one instead of every asset compilation in flight.
+	if (CreatedTexture->IsCompiling())
+	{
+		FTextureCompilingManager::Get().FinishCompilation({ CreatedTexture });
+	}
+#endif
+
+	return OutCreatedResult;
+}
+
+FTransientTextureRef CreateTransientTextureFromSource(UTexture2D* InSourceTexture, const FString& InTextureName)
 {
 	check(InSourceTexture);
 
 	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
 
 	const uint16 TextureWidth = SourceMip->SizeX, TextureHeight = SourceMip->SizeY;
-	const EPixelFormat PixelFormat = InSourceTexture->GetPixelFormat();
 
-	TArrayView64<uint8> PixelsView;
-	FByteBulkData* SourceRawImageData = nullptr;
+	return CreateTransientTextureWithSourceSettings(InSourceTexture, TextureWidth, TextureHeight, InTextureName);
+}
 
-	if (InCopySourceImage)
-	{
-		const int32 NumBlocksX = TextureWidth / GPixelFormats[PixelFormat].BlockSizeX;
-		const int32 NumBlocksY = TextureHeight / GPixelFormats[PixelFormat].BlockSizeY;
-		FGuardedInt64 BytesForImageGuarded = FGuardedInt64(NumBlocksX) * NumBlocksY * GPixelFormats[PixelFormat].BlockBytes;
-		int64 BytesForImage = BytesForImageGuarded.Get(0);
-		check(BytesForImage > 0);
+FTransientTextureTask CreateTransientTextureFromSourceAsync(UTexture2D* InSourceTexture, const FString& InTextureName)
+{
+	check(InSourceTexture);
+
+	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
+
+	return CreateTransientTextureWithSizeAsync(InSourceTexture, SourceMip->SizeX, SourceMip->SizeY, InTextureName);
+}
+
+FTransientTextureRef CreateTransientTextureWithSize(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY, const FString& InTextureName)
+{
+	check(InSourceTexture);
+	check(InSizeX > 0 && InSizeY > 0);
+
+	return CreateTransientTextureWithSourceSettings(InSourceTexture, InSizeX, InSizeY, InTextureName);
+}
+
+FTransientTextureTask CreateTransientTextureWithSizeAsync(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY, const FString& InTextureName)
+{
+	check(InSourceTexture);
+	check(InSizeX > 0 && InSizeY > 0);
+
+	FTransientTextureRef IdleTexture = FTransientTexturePool::Get().TryAcquireIdle(MakeTransientTextureKey(InSourceTexture, InSizeX, InSizeY));
 
-		SourceRawImageData = &SourceMip->BulkData;
-		FColor* SourceColorData = static_cast<FColor*>(SourceRawImageData->Lock(LOCK_READ_ONLY));
-		check(SourceColorData);
+	if (IdleTexture.IsValid())
+	{
+		ApplySourceTextureSettings(InSourceTexture, IdleTexture->GetTexture());
 
-		PixelsView = TArrayView64<uint8>((uint8*)SourceColorData, BytesForImage);
+		//Nothing left to do.
+		return UE::Tasks::MakeCompletedTask<FTransientTextureRef>(MoveTemp(IdleTexture));
 	}
 
-	UTexture2D* OutCreatedResult = UTexture2D::CreateTransient(TextureWidth, TextureHeight, PixelFormat, *InTextureName, PixelsView);
+	//Creating a new texture has to happen on the game thread.
+	return UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[SourceTexture = TWeakObjectPtr<UTexture2D>(InSourceTexture), InSizeX, InSizeY, TextureName = InTextureName]() -> FTransientTextureRef
+		{
+			//The source may be garbage collected before this runs. There is nothing to take the settings from then, the users of the texture skip it.
+			if (!SourceTexture.IsValid())
+			{
+				UE_LOG(LogThreadingSample, Warning, TEXT("The source of transient texture %s was garbage collected before it was created."), *TextureName);
+				return FTransientTextureRef();
+			}
+
+			return CreateTransientTextureWithSize(SourceTexture.Get(), InSizeX, InSizeY, TextureName);
+		},
+		LowLevelTasks::ETaskPriority::BackgroundHigh,
+		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri
+	);
+}
+
+FImageBufferRef AcquireImageBufferFromSource(UTexture2D* InSourceTexture)
+{
+	check(InSourceTexture);
+
+	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
+
+	return FImageBufferPool::Get().Acquire(SourceMip->SizeX, SourceMip->SizeY, ERawImageFormat::BGRA8, InSourceTexture->SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear);
+}
 
-	if (InSourceTexture->SRGB != OutCreatedResult->SRGB)
+FImageBufferRef AcquireIntermediateImageBuffer(UTexture2D* InSourceTexture, EIntermediatePrecision InIntermediatePrecision)
+{
+	check(InSourceTexture);
+
+	FTexture2DMipMap* SourceMip = &InSourceTexture->GetPlatformData()->Mips[0];
+
+	switch (InIntermediatePrecision)
 	{
-		OutCreatedResult->SRGB = InSourceTexture->SRGB;
+	case EIntermediatePrecision::Half:
+		return FImageBufferPool::Get().Acquire(SourceMip->SizeX, SourceMip->SizeY, ERawImageFormat::RGBA16F, EGammaSpace::Linear);
+	case EIntermediatePrecision::Float:
+		return FImageBufferPool::Get().Acquire(SourceMip->SizeX, SourceMip->SizeY, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	default:
+		return AcquireImageBufferFromSource(InSourceTexture);
 	}
+}
 
-	if (InSourceTexture->CompressionSettings != OutCreatedResult->CompressionSettings)
+FGraphEventRef MakeGraphEventFromTask(const UE::Tasks::FTask& InTask)
+{
+	FGraphEventRef GraphEvent = FGraphEvent::CreateGraphEvent();
+
+	//Inline tasks are executed by the thread that completes their last prerequisite, no extra scheduling round trip.
+	UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[GraphEvent]()
+		{
+			GraphEvent->DispatchSubsequents();
+		},
+		UE::Tasks::Prerequisites(InTask),
+		LowLevelTasks::ETaskPriority::BackgroundHigh,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+
+	return GraphEvent;
+}
+
+UE::Tasks::FTask MakeTaskFromGraphEvent(const FGraphEventRef& InGraphEvent)
+{
+	UE::Tasks::FTaskEvent TaskEvent(UE_SOURCE_LOCATION);
+
+	FFunctionGraphTask::CreateAndDispatchWhenReady(
+		[TaskEvent]() mutable
+		{
+			TaskEvent.Trigger();
+		},
+		TStatId{}, InGraphEvent, ENamedThreads::AnyHiPriThreadHiPriTask);
+
+	return TaskEvent;
+}
+
+UTexture2D* FTaskImage::ResolveTexture() const
+{
+	if (TransientTexture.IsValid())
 	{
-		OutCreatedResult->CompressionSettings = InSourceTexture->CompressionSettings;
+		//The creation task is a prerequisite of every task that resolves it, GetResult() never waits here.
+		check(TransientTexture.IsCompleted());
+		return GetTransientTexture(TransientTexture);
 	}
 
-#if WITH_EDITORONLY_DATA
-	if (InSourceTexture->MipGenSettings != OutCreatedResult->MipGenSettings)
+	return Texture.Get();
+}
+
+bool FTaskImage::IsAvailable() const
+{
+	return ImageBuffer.IsValid() || SourceImage.IsValid() || ResolveTexture() != nullptr;
+}
+
+FScopedTaskImageAccess::FScopedTaskImageAccess(const FTaskImage& InImage, uint32 InLockFlags)
+{
+	if (FImage* ImageBuffer = InImage.GetImageBuffer())
 	{
-		OutCreatedResult->MipGenSettings = InSourceTexture->MipGenSettings;
+		View = FImageView(*ImageBuffer, ImageBuffer->RawData.GetData());
+		return;
 	}
-#endif
 
-	if (InCopySourceImage)
+	if (const FSourceImageSnapshot* SourceImage = InImage.GetSourceImage())
 	{
-		SourceRawImageData->Unlock();
+		//Snapshots are shared by concurrent readers.
+		check(InLockFlags == LOCK_READ_ONLY);
+		View = SourceImage->GetView();
+		return;
 	}
 
-	//Add to root set incase it gets GCed.
-	//TODO: RemoveFromRoot
-	OutCreatedResult->AddToRoot();
-	//OutCreatedResult->RemoveFromRoot();
+	UTexture2D* Texture = InImage.ResolveTexture();
+	check(Texture && Texture->GetPixelFormat() == PF_B8G8R8A8);
 
-	FAssetCompilingManager::Get().ProcessAsyncTasks();
-	FAssetCompilingManager::Get().FinishAllCompilation();
+	FTexture2DMipMap* Mip = &Texture->GetPlatformData()->Mips[0];
+	LockedBulkData = &Mip->BulkData;
 
-	return OutCreatedResult;
+	void* ColorData = LockedBulkData->Lock(InLockFlags);
+	check(ColorData);
+
+	View = FImageView(ColorData, Mip->SizeX, Mip->SizeY, 1, ERawImageFormat::BGRA8, Texture->SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear);
+}
+
+FScopedTaskImageAccess::~FScopedTaskImageAccess()
+{
+	if (LockedBulkData)
+	{
+		LockedBulkData->Unlock();
+	}
 }
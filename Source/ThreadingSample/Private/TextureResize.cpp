@@ -0,0 +1,314 @@
+#include "TextureResize.h"
+
+#include "SourceImageSnapshot.h"
+#include "Misc/MemStack.h"
+
+//Rows processed by one ParallelFor loop body.
+static constexpr int32 ResizeRowsPerBand = 16;
+
+const TCHAR* EResizeFilterToString(EResizeFilter InResizeFilter)
+{
+	const TCHAR* ConvertTable[] = {
+		TEXT("Mitchell"),
+		TEXT("Lanczos3")
+	};
+
+	return ConvertTable[int32(InResizeFilter)];
+}
+
+static float GetResizeKernelSupport(EResizeFilter InResizeFilter)
+{
+	switch (InResizeFilter)
+	{
+	case EResizeFilter::Mitchell:
+		return 2.0f;
+	case EResizeFilter::Lanczos3:
+		return 3.0f;
+	default:
+		check(false);
+		return 0.0f;
+	}
+}
+
+static float EvaluateResizeKernel(EResizeFilter InResizeFilter, float InX)
+{
+	const float X = FMath::Abs(InX);
+
+	switch (InResizeFilter)
+	{
+	case EResizeFilter::Mitchell:
+	{
+		constexpr float B = 1.0f / 3.0f;
+		constexpr float C = 1.0f / 3.0f;
+
+		if (X < 1.0f)
+		{
+			return ((12.0f - 9.0f * B - 6.0f * C) * X * X * X + (-18.0f + 12.0f * B + 6.0f * C) * X * X + (6.0f - 2.0f * B)) / 6.0f;
+		}
+		else if (X < 2.0f)
+		{
+			return ((-B - 6.0f * C) * X * X * X + (6.0f * B + 30.0f * C) * X * X + (-12.0f * B - 48.0f * C) * X + (8.0f * B + 24.0f * C)) / 6.0f;
+		}
+		return 0.0f;
+	}
+	case EResizeFilter::Lanczos3:
+	{
+		if (X < UE_SMALL_NUMBER)
+		{
+			return 1.0f;
+		}
+		else if (X < 3.0f)
+		{
+			const float PiX = PI * X;
+			return 3.0f * FMath::Sin(PiX) * FMath::Sin(PiX / 3.0f) / (PiX * PiX);
+		}
+		return 0.0f;
+	}
+	default:
+		check(false);
+		return 0.0f;
+	}
+}
+
+void BuildResizeWeightTable(EResizeFilter InResizeFilter, int32 InSourceSize, int32 InTargetSize, FResizeWeightTable& OutTable)
+{
+	check(InSourceSize > 0 && InTargetSize > 0);
+
+	OutTable.FirstSourceIndex.Reset();
+	OutTable.Weights.Reset();
+
+	if (InSourceSize == InTargetSize)
+	{
+		//Nothing to resample along this axis. Mitchell is not an interpolating filter and would blur the image otherwise.
+		OutTable.NumTaps = 1;
+		OutTable.FirstSourceIndex.SetNumUninitialized(InTargetSize);
+		OutTable.Weights.Init(1.0f, InTargetSize);
+		for (int32 i = 0; i < InTargetSize; ++i)
+		{
+			OutTable.FirstSourceIndex[i] = i;
+		}
+		return;
+	}
+
+	const float Scale = float(InTargetSize) / float(InSourceSize);
+	//When downscaling the kernel is stretched over the footprint of a destination pixel so it acts as a low pass filter.
+	const float FilterScale = FMath::Max(1.0f / Scale, 1.0f);
+	const float Support = GetResizeKernelSupport(InResizeFilter) * FilterScale;
+
+	OutTable.NumTaps = FMath::Min(FMath::CeilToInt32(Support * 2.0f) + 1, InSourceSize);
+	OutTable.FirstSourceIndex.SetNumUninitialized(InTargetSize);
+	OutTable.Weights.SetNumZeroed(InTargetSize * OutTable.NumTaps);
+
+	for (int32 TargetIndex = 0; TargetIndex < InTargetSize; ++TargetIndex)
+	{
+		//Center of the destination pixel in source pixel coordinates.
+		const float Center = (TargetIndex + 0.5f) / Scale - 0.5f;
+		const int32 First = FMath::FloorToInt32(Center - Support) + 1;
+		const int32 Last = FMath::CeilToInt32(Center + Support) - 1;
+
+		//Keep the whole window inside the source so no per tap clamping is needed when filtering.
+		const int32 WindowStart = FMath::Clamp(First, 0, InSourceSize - OutTable.NumTaps);
+		float* Weights = &OutTable.Weights[TargetIndex * OutTable.NumTaps];
+
+		float SumWeight = 0.0f;
+		for (int32 SourceIndex = First; SourceIndex <= Last; ++SourceIndex)
+		{
+			const float Weight = EvaluateResizeKernel(InResizeFilter, (SourceIndex - Center) / FilterScale);
+			//Taps outside of the source are folded onto the edge pixels (clamp addressing).
+			const int32 Slot = FMath::Clamp(SourceIndex, 0, InSourceSize - 1) - WindowStart;
+			check(Slot >= 0 && Slot < OutTable.NumTaps);
+
+			Weights[Slot] += Weight;
+			SumWeight += Weight;
+		}
+
+		//Normalize weights.
+		if (FMath::Abs(SumWeight) > UE_SMALL_NUMBER)
+		{
+			for (int32 Tap = 0; Tap < OutTable.NumTaps; ++Tap)
+			{
+				Weights[Tap] /= SumWeight;
+			}
+		}
+
+		OutTable.FirstSourceIndex[TargetIndex] = WindowStart;
+	}
+}
+
+void ResizeImage(const FImageView& InSource, const FImageView& OutResized, EResizeFilter InResizeFilter, bool InForceSingleThread)
+{
+	check(InSource.Format == ERawImageFormat::BGRA8 && OutResized.Format == ERawImageFormat::BGRA8);
+	check(InSource.GetGammaSpace() == OutResized.GetGammaSpace());
+
+	const FColor* SourceColorData = static_cast<const FColor*>(InSource.RawData);
+	FColor* ResizedColorData = static_cast<FColor*>(OutResized.RawData);
+
+	const int32 SourceWidth = InSource.SizeX;
+	const int32 SourceHeight = InSource.SizeY;
+	const int32 TargetWidth = OutResized.SizeX;
+	const int32 TargetHeight = OutResized.SizeY;
+
+	const bool IsSRGB = InSource.GetGammaSpace() == EGammaSpace::sRGB;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FResizeWeightTable HorizontalTable, VerticalTable;
+	BuildResizeWeightTable(InResizeFilter, SourceWidth, TargetWidth, HorizontalTable);
+	BuildResizeWeightTable(InResizeFilter, SourceHeight, TargetHeight, VerticalTable);
+
+	//Decode table from 8 bit color to linear space.
+	float DecodeTable[256];
+	for (int32 i = 0; i < 256; ++i)
+	{
+		DecodeTable[i] = IsSRGB ? FLinearColor::sRGBToLinearTable[i] : i / 255.0f;
+	}
+
+	const EParallelForFlags ParallelForFlags = InForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+	//The horizontal pass output, TargetWidth x SourceHeight pixels in linear space.
+	TArray64<FLinearColor> Intermediate;
+	Intermediate.SetNumUninitialized(int64(TargetWidth) * SourceHeight);
+
+	//Horizontal pass. Every source row is decoded once into a scratch row so the inner loop only does multiply-adds on 4-wide vectors.
+	ParallelFor(
+		TEXT("Parallel Resize Horizontal Pass"),
+		FMath::DivideAndRoundUp(SourceHeight, ResizeRowsPerBand),
+		1,
+		[&](int32 BandIndex) {
+			//Scratch rows are bump allocated from the FMemStack of the worker running the band.
+			FMemMark Mark(FMemStack::Get());
+
+			TArray<FLinearColor, TMemStackAllocator<>> DecodedRow;
+			DecodedRow.SetNumUninitialized(SourceWidth);
+
+			const int32 RowBegin = BandIndex * ResizeRowsPerBand;
+			const int32 RowEnd = FMath::Min(RowBegin + ResizeRowsPerBand, SourceHeight);
+
+			for (int32 Y = RowBegin; Y < RowEnd; ++Y)
+			{
+				const FColor* SourceRow = SourceColorData + int64(Y) * SourceWidth;
+				for (int32 X = 0; X < SourceWidth; ++X)
+				{
+					const FColor Color = SourceRow[X];
+					DecodedRow[X] = FLinearColor(DecodeTable[Color.R], DecodeTable[Color.G], DecodeTable[Color.B], Color.A / 255.0f);
+				}
+
+				FLinearColor* IntermediateRow = &Intermediate[int64(Y) * TargetWidth];
+				for (int32 X = 0; X < TargetWidth; ++X)
+				{
+					const float* Weights = &HorizontalTable.Weights[X * HorizontalTable.NumTaps];
+					const FLinearColor* Taps = &DecodedRow[HorizontalTable.FirstSourceIndex[X]];
+
+					VectorRegister4Float Sum = VectorZeroFloat();
+					for (int32 Tap = 0; Tap < HorizontalTable.NumTaps; ++Tap)
+					{
+						Sum = VectorMultiplyAdd(VectorLoad(&Taps[Tap].R), VectorSetFloat1(Weights[Tap]), Sum);
+					}
+					VectorStore(Sum, &IntermediateRow[X].R);
+				}
+			}
+		},
+		ParallelForFlags);
+
+	//Vertical pass. Whole intermediate rows are accumulated so memory is walked linearly, then encoded straight into the output texture.
+	ParallelFor(
+		TEXT("Parallel Resize Vertical Pass"),
+		FMath::DivideAndRoundUp(TargetHeight, ResizeRowsPerBand),
+		1,
+		[&](int32 BandIndex) {
+			FMemMark Mark(FMemStack::Get());
+
+			TArray<FLinearColor, TMemStackAllocator<>> AccumulatedRow;
+			AccumulatedRow.SetNumUninitialized(TargetWidth);
+
+			const int32 RowBegin = BandIndex * ResizeRowsPerBand;
+			const int32 RowEnd = FMath::Min(RowBegin + ResizeRowsPerBand, TargetHeight);
+
+			for (int32 Y = RowBegin; Y < RowEnd; ++Y)
+			{
+				const float* Weights = &VerticalTable.Weights[Y * VerticalTable.NumTaps];
+				const int32 FirstRow = VerticalTable.FirstSourceIndex[Y];
+
+				FMemory::Memzero(AccumulatedRow.GetData(), AccumulatedRow.Num() * sizeof(FLinearColor));
+
+				for (int32 Tap = 0; Tap < VerticalTable.NumTaps; ++Tap)
+				{
+					const VectorRegister4Float Weight = VectorSetFloat1(Weights[Tap]);
+					const FLinearColor* IntermediateRow = &Intermediate[int64(FirstRow + Tap) * TargetWidth];
+
+					for (int32 X = 0; X < TargetWidth; ++X)
+					{
+						VectorStore(VectorMultiplyAdd(VectorLoad(&IntermediateRow[X].R), Weight, VectorLoad(&AccumulatedRow[X].R)), &AccumulatedRow[X].R);
+					}
+				}
+
+				//ToFColor clamps the negative lobes and overshoots of the kernels.
+				FColor* ResizedRow = ResizedColorData + int64(Y) * TargetWidth;
+				for (int32 X = 0; X < TargetWidth; ++X)
+				{
+					ResizedRow[X] = AccumulatedRow[X].ToFColor(IsSRGB);
+				}
+			}
+		},
+		ParallelForFlags);
+
+	const double EndTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogThreadingSample, Display, TEXT("Resize Image(%s, %s, %dx%d -> %dx%d, Taps: %dx%d) Execution Finished in %f Seconds."),
+		EResizeFilterToString(InResizeFilter),
+		InForceSingleThread ? TEXT("Singlethreaded") : TEXT("Multithreaded"),
+		SourceWidth, SourceHeight, TargetWidth, TargetHeight,
+		HorizontalTable.NumTaps, VerticalTable.NumTaps,
+		EndTime - StartTime);
+}
+
+void ResizeTexture(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutResizedTexture, EResizeFilter InResizeFilter, bool InForceSingleThread)
+{
+	check(InSourceTexture.Get() && OutResizedTexture.Get());
+	check(InSourceTexture->SRGB == OutResizedTexture->SRGB);
+
+	//Read through a snapshot so a pipeline reading the same source at the same time does not trip the bulk data lock.
+	FSourceImageRef SourceImage = AcquireSourceImageSnapshot(InSourceTexture.Get());
+
+	FTexture2DMipMap* ResizedMip = &OutResizedTexture->GetPlatformData()->Mips[0];
+	FByteBulkData* ResizedRawImageData = &ResizedMip->BulkData;
+	void* ResizedColorData = ResizedRawImageData->Lock(LOCK_READ_WRITE);
+	check(ResizedColorData);
+
+	const FImageView ResizedView(ResizedColorData, ResizedMip->SizeX, ResizedMip->SizeY, 1, ERawImageFormat::BGRA8, SourceImage->GetView().GetGammaSpace());
+
+	ResizeImage(SourceImage->GetView(), ResizedView, InResizeFilter, InForceSingleThread);
+
+	ResizedRawImageData->Unlock();
+}
+
+bool ValidateResizeParameters(UTexture2D* InSourceTexture, int32 InTargetWidth, int32 InTargetHeight)
+{
+	if (!IsValid(InSourceTexture))
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Invalid source texture!!!"));
+		return false;
+	}
+
+	if (InTargetWidth <= 0 || InTargetWidth > 8192 || InTargetHeight <= 0 || InTargetHeight > 8192)
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Invalid target size:[%dx%d]. Valid target size range [1, 8192]."), InTargetWidth, InTargetHeight);
+		return false;
+	}
+
+	if (InSourceTexture->CompressionSettings != TextureCompressionSettings::TC_VectorDisplacementmap)
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Currently only support texture with compression setting [VectorDisplacementmap (RGBA8)]."));
+		return false;
+	}
+
+#if WITH_EDITORONLY_DATA
+	if (InSourceTexture->MipGenSettings != TextureMipGenSettings::TMGS_NoMipmaps)
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Currently only support texture with mipmap generation setting [TMGS_NoMipmaps]."));
+		return false;
+	}
+#endif
+
+	return true;
+}
@@ -0,0 +1,53 @@
+#include "TextureUpload.h"
+
+#include "SourceImageSnapshot.h"
+
+#include "Engine/Texture2D.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+
+void UploadTextureRegions(UTexture2D* InTexture, TArray<FUpdateTextureRegion2D> InDirtyRegions)
+{
+	check(IsInGameThread());
+	check(InTexture && InTexture->GetPixelFormat() == PF_B8G8R8A8);
+
+	const FTexture2DMipMap& Mip = InTexture->GetPlatformData()->Mips[0];
+
+	FTextureResource* Resource = InTexture->GetResource();
+
+	if (!Resource || Resource->GetSizeX() != uint32(Mip.SizeX) || Resource->GetSizeY() != uint32(Mip.SizeY))
+	{
+		//Nothing to update in place, the resource is created from the mip.
+		InTexture->UpdateResource();
+		return;
+	}
+
+	if (InDirtyRegions.IsEmpty())
+	{
+		InDirtyRegions.Add(FUpdateTextureRegion2D(0, 0, 0, 0, Mip.SizeX, Mip.SizeY));
+	}
+
+	//Keeps the mip locked for reading until the render command has consumed it.
+	FSourceImageRef Pixels = AcquireSourceImageSnapshot(InTexture);
+
+	ENQUEUE_RENDER_COMMAND(UploadTextureRegions)(
+		[Resource, Pixels, DirtyRegions = MoveTemp(InDirtyRegions)](FRHICommandListImmediate& RHICmdList)
+		{
+			FRHITexture* TextureRHI = Resource->GetTexture2DRHI();
+			if (!TextureRHI)
+			{
+				return;
+			}
+
+			const FImageView& View = Pixels->GetView();
+			const uint32 SourcePitch = View.SizeX * sizeof(FColor);
+			const uint8* SourceData = static_cast<const uint8*>(View.RawData);
+
+			for (const FUpdateTextureRegion2D& Region : DirtyRegions)
+			{
+				check(Region.SrcX + Region.Width <= uint32(View.SizeX) && Region.SrcY + Region.Height <= uint32(View.SizeY));
+
+				RHIUpdateTexture2D(TextureRHI, 0, Region, SourcePitch, SourceData + Region.SrcY * SourcePitch + Region.SrcX * sizeof(FColor));
+			}
+		});
+}
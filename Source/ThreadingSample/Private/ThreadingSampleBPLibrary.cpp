@@ -3,6 +3,12 @@
 #include "QueuedThreadPoolWrapper.h"
 #include "QueuedThreadPoolWorks.h"
 
+#include "FilterResultCache.h"
+#include "FilterPreview.h"
+#include "FilterPipelineGraph.h"
+#include "TextureContentHash.h"
+#include "TaskCoroutine.h"
+
 #include "Algo/RandomShuffle.h"
 
 /*----------------------------------------------------------------------------------
@@ -47,7 +53,25 @@ void UThreadingSampleBPLibrary::LoadTextFiles(ELoadTextFileExecution InExecution
 /*----------------------------------------------------------------------------------
 	Texture Filter Samples
 ----------------------------------------------------------------------------------*/
-void UThreadingSampleBPLibrary::FilterTextureUsingParallelFor(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InOnePass, bool InForceSingleThread, UTexture2D*& OutFilteredTexture)
+//Resize before filtering when the full resolution is not needed, the filter cost scales with the number of pixels.
+void UThreadingSampleBPLibrary::ResizeTexture(UTexture2D* InSourceTexture, int32 InTargetWidth, int32 InTargetHeight, EResizeFilter InResizeFilter, bool InForceSingleThread, UTexture2D*& OutResizedTexture)
+{
+	if (!ValidateResizeParameters(InSourceTexture, InTargetWidth, InTargetHeight))
+	{
+		OutResizedTexture = nullptr;
+		return;
+	}
+
+	FTransientTextureRef ResizeResult = CreateTransientTextureWithSize(InSourceTexture, InTargetWidth, InTargetHeight, TEXT("ResizeResult"));
+
+	::ResizeTexture(InSourceTexture, ResizeResult->GetTexture(), InResizeFilter, InForceSingleThread);
+	UploadTextureRegions(ResizeResult->GetTexture());
+
+	//The caller owns the resized texture.
+	OutResizedTexture = ResizeResult->Detach();
+}
+
+void UThreadingSampleBPLibrary::FilterTextureUsingParallelFor(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InOnePass, bool InForceSingleThread, EIntermediatePrecision InIntermediatePrecision, UTexture2D*& OutFilteredTexture)
 {
 	if (!ValidateParameters(InSourceTexture, InFilterSize, InScaleValue))
 	{
@@ -55,50 +79,116 @@ void UThreadingSampleBPLibrary::FilterTextureUsingParallelFor(UTexture2D* InSour
 		return;
 	}
 
-	if (!InOnePass)
+	//Other pipelines may read the same source at the same time.
+	FSourceImageRef SourceImage = AcquireSourceImageSnapshot(InSourceTexture);
+
+	//Keys both the result cache and the stage cache. Not computed if neither is enabled, it is a full pass over the source.
+	//Unlike the task based pipelines(see FFilterPipelineRequest::GetCachedResult()) this function blocks the caller until the result is uploaded anyway,
+	//so it hashes with ParallelFor right here instead of waiting for hash tasks.
+	TOptional<uint64> SourceHash;
+	if (FFilterResultCache::IsEnabled() || FPipelineStageCache::IsEnabled())
+	{
+		SourceHash = ComputeImageContentHash(SourceImage->GetView(), InForceSingleThread);
+	}
+
+	//Identical requests reuse the cached result. Like the results of the async functions it is shared, the lease is exposed so it never goes back to the pool.
+	TOptional<FFilterResultKey> CacheKey;
+	if (FFilterResultCache::IsEnabled() && SourceHash)
 	{
-		UTexture2D* VerticalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("VerticalPassResult"));
-		UTexture2D* HorizontalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("HorizontalPassResult"));
-		UTexture2D* ScaleAlphaResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaResult"));
-		UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
+		CacheKey = MakeFilterResultKey(*SourceHash, InFilterType, InFilterSize, InScaleValue, InIntermediatePrecision, InOnePass);
+
+		if (FTransientTextureRef CachedResult = FFilterResultCache::Get().Find(*CacheKey))
+		{
+			CachedResult->MarkExposed();
+			OutFilteredTexture = CachedResult->GetTexture();
+			return;
+		}
+	}
+
+	//Only the stages whose parameters changed since an earlier request run again.
+	//A cached stage may come from a task based pipeline that is still running, this pipeline is synchronous so it waits for it.
+	//The game thread is blocked meanwhile, so it only waits for stages running at interactive priority.
+	const FPipelineStageKey BlurKey = MakeBlurStageKey(SourceHash.Get(0), InFilterType, InFilterSize, InIntermediatePrecision, InOnePass);
+	TOptional<FPipelineStageResult> BlurStage = SourceHash ? FPipelineStageCache::Get().Find(BlurKey, EFilterQoS::Interactive) : TOptional<FPipelineStageResult>();
+
+	if (BlurStage)
+	{
+		BlurStage->Task.Wait();
+	}
+	else if (!InOnePass)
+	{
+		//Intermediate results live in pooled image buffers, only the final result is written to a texture and uploaded.
+		FImageBufferRef VerticalPassResult = AcquireIntermediateImageBuffer(InSourceTexture, InIntermediatePrecision);
+		FImageBufferRef HorizontalPassResult = AcquireImageBufferFromSource(InSourceTexture);
 
 		//1D vertical pass
-		FilterTexture(InSourceTexture, VerticalPassResult, InFilterType, InFilterSize, EConvolutionType::OneDVertical, InForceSingleThread);
-		VerticalPassResult->UpdateResource();
+		FilterTexture(SourceImage, VerticalPassResult, InFilterType, InFilterSize, EConvolutionType::OneDVertical, InForceSingleThread);
 
 		//1D horizontal pass
 		FilterTexture(VerticalPassResult, HorizontalPassResult, InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, InForceSingleThread);
-		HorizontalPassResult->UpdateResource();
 
-		ScaleAlphaChannel(InSourceTexture, ScaleAlphaResult, InScaleValue, InForceSingleThread);
-		ScaleAlphaResult->UpdateResource();
+		BlurStage = FPipelineStageResult{ HorizontalPassResult, UE::Tasks::MakeCompletedTask<void>() };
+		if (SourceHash)
+		{
+			FPipelineStageCache::Get().Add(BlurKey, *BlurStage);
+		}
+	}
+	else
+	{
+		FImageBufferRef FilteredResult = AcquireImageBufferFromSource(InSourceTexture);
+
+		//A single 2d pass
+		FilterTexture(SourceImage, FilteredResult, InFilterType, InFilterSize, EConvolutionType::TwoD, InForceSingleThread);
+
+		BlurStage = FPipelineStageResult{ FilteredResult, UE::Tasks::MakeCompletedTask<void>() };
+		if (SourceHash)
+		{
+			FPipelineStageCache::Get().Add(BlurKey, *BlurStage);
+		}
+	}
 
-		CompositeRGBAValue(HorizontalPassResult, ScaleAlphaResult, CompositeResult, InForceSingleThread);
-		CompositeResult->UpdateResource();
+	const FPipelineStageKey ScaleAlphaKey = MakeScaleAlphaStageKey(SourceHash.Get(0), InScaleValue);
+	TOptional<FPipelineStageResult> ScaleAlphaStage = SourceHash ? FPipelineStageCache::Get().Find(ScaleAlphaKey, EFilterQoS::Interactive) : TOptional<FPipelineStageResult>();
 
-		OutFilteredTexture = CompositeResult;
+	if (ScaleAlphaStage)
+	{
+		ScaleAlphaStage->Task.Wait();
 	}
 	else
 	{
-		UTexture2D* FilteredResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("FilteredResult"));
-		UTexture2D* ScaleAlphaResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaResult"));
-		UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
+		FImageBufferRef ScaleAlphaResult = AcquireImageBufferFromSource(InSourceTexture);
 
-		//A single 2d pass
-		FilterTexture(InSourceTexture, FilteredResult, InFilterType, InFilterSize, EConvolutionType::TwoD, InForceSingleThread);
-		FilteredResult->UpdateResource();
+		ScaleAlphaChannel(SourceImage, ScaleAlphaResult, InScaleValue, InForceSingleThread);
 
-		ScaleAlphaChannel(InSourceTexture, ScaleAlphaResult, InScaleValue, InForceSingleThread);
-		ScaleAlphaResult->UpdateResource();
+		ScaleAlphaStage = FPipelineStageResult{ ScaleAlphaResult, UE::Tasks::MakeCompletedTask<void>() };
+		if (SourceHash)
+		{
+			FPipelineStageCache::Get().Add(ScaleAlphaKey, *ScaleAlphaStage);
+		}
+	}
+
+	FTransientTextureRef CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
 
-		CompositeRGBAValue(FilteredResult, ScaleAlphaResult, CompositeResult, InForceSingleThread);
-		CompositeResult->UpdateResource();
+	CompositeRGBAValue(BlurStage->Image, ScaleAlphaStage->Image, CompositeResult->GetTexture(), InForceSingleThread);
 
-		OutFilteredTexture = CompositeResult;
+	UploadTextureRegions(CompositeResult->GetTexture());
+
+	if (CacheKey)
+	{
+		//The cache keeps the leased result and the caller gets the same texture, no copy is made or uploaded.
+		//Exposed, it leaves the pool once the cache drops it, while the caller can still keep it.
+		CompositeResult->MarkExposed();
+		FFilterResultCache::Get().Add(*CacheKey, CompositeResult);
+		OutFilteredTexture = CompositeResult->GetTexture();
+	}
+	else
+	{
+		//The caller owns the final texture, the image buffers go back to the pool(or stay in the stage cache) when they go out of scope.
+		OutFilteredTexture = CompositeResult->Detach();
 	}
 }
 
-void UThreadingSampleBPLibrary::FilterTextureUsingTaskSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, UResultUsingTaskSystem*& OutResult)
+void UThreadingSampleBPLibrary::FilterTextureUsingTaskSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskSystem*& OutResult)
 {
 	if (!ValidateParameters(InSourceTexture, InFilterSize, InScaleValue))
 	{
@@ -106,115 +196,240 @@ void UThreadingSampleBPLibrary::FilterTextureUsingTaskSystem(UTexture2D* InSourc
 		return;
 	}
 
-	UTexture2D* VerticalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("VerticalPassResult"));
-	UTexture2D* HorizontalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("HorizontalPassResult"));
-	//We need ScaleAlphaChannelInput here because the first filter task and scale alpha channel task could overlap their execution.
-	//The calling of Lock() and Unlock() could assert in such case if we pass InSourceTexture to both tasks.
-	//We just duplicate InSourceTexture to another texture which we pass to scale alpha channel task for simplicity.
-	UTexture2D* ScaleAlphaChannelInput = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelInput"), true);
-	UTexture2D* ScaleAlphaChannelResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelResult"));
-	UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
+	//The QoS picks the priority of every task of the request, its deadline counts from now.
+	FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture,
+		{ InFilterType, InFilterSize, InScaleValue, InIntermediatePrecision, FFilterQoS::Make(InQoS, InDeadlineSeconds) });
 
-	auto VerticalPassTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(InSourceTexture),
-		FilteredResult = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-		InFilterType, InFilterSize]()
-		{
-			FilterTexture(SourceTexture, FilteredResult, InFilterType, InFilterSize, EConvolutionType::OneDVertical, false);
-		},
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+	//Both 1D passes run as a wavefront of row bands, the horizontal pass of a band starts as soon as its rows went through the vertical pass.
+	Request->Launch(EFilterPipelineBackend::Tasks);
 
-	auto VerticalPassResultUpdateTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(VerticalPassResult)]()
-		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(VerticalPassTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+	OutResult = NewObject<UResultUsingTaskSystem>();
 
-	auto HorizontalPassTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-		FilteredResult = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-		InFilterType, InFilterSize]()
+	//Canceled through the result object.
+	OutResult->SetResult(Request->GetResult(), Request->GetCompletionTask(), Request->GetCancellation());
+
+	//Runs alongside the full resolution pipeline and arrives first through the same result object.
+	if (InProgressivePreview && ShouldLaunchFilterPreview(InSourceTexture))
+	{
+		OutResult->SetPreview(LaunchFilterPreview(InSourceTexture, Request->GetSourceImage(), InFilterType, InFilterSize, InScaleValue, Request->GetCancellation(), Request->GetCompletionTask()));
+	}
+}
+
+void UThreadingSampleBPLibrary::BenchmarkIntermediatePrecision(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumIterations)
+{
+	if (!ValidateParameters(InSourceTexture, InFilterSize, 1.0f))
+	{
+		return;
+	}
+
+	InNumIterations = FMath::Max(InNumIterations, 1);
+
+	FSourceImageRef SourceImage = AcquireSourceImageSnapshot(InSourceTexture);
+
+	//Keys the linear copy of the source, so only the first warm up run decodes it.
+	const uint64 SourceHash = ComputeImageContentHash(SourceImage->GetView());
+
+	//The float intermediate goes first, its result is the reference the other precisions are compared against.
+	const EIntermediatePrecision Precisions[] = { EIntermediatePrecision::Float, EIntermediatePrecision::Half, EIntermediatePrecision::EightBit };
+
+	FImageBufferRef Reference = AcquireImageBufferFromSource(InSourceTexture);
+
+	for (EIntermediatePrecision Precision : Precisions)
+	{
+		FImageBufferRef VerticalPassResult = AcquireIntermediateImageBuffer(InSourceTexture, Precision);
+		FImageBufferRef Filtered = Precision == EIntermediatePrecision::Float ? Reference : AcquireImageBufferFromSource(InSourceTexture);
+
+		//Warm up run, also decodes the source into the linear image cache if it is not there yet.
+		LaunchWavefrontFilter(SourceImage, SourceHash, VerticalPassResult, Filtered, InFilterType, InFilterSize).Wait();
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < InNumIterations; ++Iteration)
 		{
-			FilterTexture(SourceTexture, FilteredResult, InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, false);
-		},
-		UE::Tasks::Prerequisites(VerticalPassResultUpdateTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+			LaunchWavefrontFilter(SourceImage, SourceHash, VerticalPassResult, Filtered, InFilterType, InFilterSize).Wait();
+		}
 
-	auto HorizontalPassResultUpdateTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(HorizontalPassResult)]()
+		const double SecondsPerRun = (FPlatformTime::Seconds() - StartTime) / InNumIterations;
+
+		//Every run writes the intermediate once(vertical pass) and reads it FilterSize times per pixel(horizontal pass), the traffic scales with its size.
+		const int64 IntermediateBytes = VerticalPassResult->GetImageSizeBytes();
+
+		//Error of the RGB channels against the float intermediate.
+		const TArrayView64<FColor> FilteredColors = Filtered->AsBGRA8();
+		const TArrayView64<FColor> ReferenceColors = Reference->AsBGRA8();
+
+		int32 MaxError = 0;
+		double SumSquaredError = 0.0;
+		for (int64 Index = 0; Index < FilteredColors.Num(); ++Index)
 		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(HorizontalPassTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+			const int32 ErrorR = FMath::Abs(int32(FilteredColors[Index].R) - int32(ReferenceColors[Index].R));
+			const int32 ErrorG = FMath::Abs(int32(FilteredColors[Index].G) - int32(ReferenceColors[Index].G));
+			const int32 ErrorB = FMath::Abs(int32(FilteredColors[Index].B) - int32(ReferenceColors[Index].B));
 
-	auto ScaleAlphaChannelTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelInput),
-		ScaledResult = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-		InScaleValue]()
+			MaxError = FMath::Max3(MaxError, ErrorR, FMath::Max(ErrorG, ErrorB));
+			SumSquaredError += double(ErrorR * ErrorR + ErrorG * ErrorG + ErrorB * ErrorB);
+		}
+
+		const double MeanSquaredError = SumSquaredError / (3.0 * FilteredColors.Num());
+		const double PSNR = MeanSquaredError > 0.0 ? 10.0 * FMath::LogX(10.0, 255.0 * 255.0 / MeanSquaredError) : TNumericLimits<double>::Max();
+
+		UE_LOG(LogThreadingSample, Display, TEXT("Intermediate Precision Benchmark(%s, Texture Size: %dx%d, Filter Size: %d): %s, %f Seconds Per Run, Intermediate: %lld Bytes, Max Error: %d, PSNR: %.2f dB."),
+			EFilterTypeToString(InFilterType),
+			Filtered->SizeX, Filtered->SizeY, InFilterSize,
+			EIntermediatePrecisionToString(Precision),
+			SecondsPerRun,
+			IntermediateBytes,
+			MaxError,
+			PSNR);
+	}
+}
+
+void UThreadingSampleBPLibrary::BenchmarkContentHash(UTexture2D* InSourceTexture, int32 InNumIterations)
+{
+	if (!IsValid(InSourceTexture) || InSourceTexture->GetPixelFormat() != PF_B8G8R8A8)
+	{
+		UE_LOG(LogThreadingSample, Warning, TEXT("Invalid source texture!!!"));
+		return;
+	}
+
+	InNumIterations = FMath::Max(InNumIterations, 1);
+
+	FSourceImageRef SourceImage = AcquireSourceImageSnapshot(InSourceTexture);
+	const FImageView& SourceView = SourceImage->GetView();
+
+	auto RunBenchmark = [&SourceView, InNumIterations](const TCHAR* InBackendName, TFunctionRef<uint64()> InHash)
 		{
-			ScaleAlphaChannel(SourceTexture, ScaledResult, InScaleValue, false);
-		},
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+			//Warm up run, also brings the pixels into memory.
+			const uint64 Hash = InHash();
 
-	auto ScaleAlphaChannelResultUpdateTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult)]()
+			const double StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < InNumIterations; ++Iteration)
+			{
+				verify(InHash() == Hash);
+			}
+
+			const double SecondsPerRun = (FPlatformTime::Seconds() - StartTime) / InNumIterations;
+
+			UE_LOG(LogThreadingSample, Display, TEXT("Content Hash Benchmark(%s, Texture Size: %dx%d): %016llx, %f Seconds Per Run, %.2f GB/s."),
+				InBackendName,
+				SourceView.SizeX, SourceView.SizeY,
+				Hash,
+				SecondsPerRun,
+				SourceView.GetImageSizeBytes() / SecondsPerRun / (1024.0 * 1024.0 * 1024.0));
+		};
+
+	RunBenchmark(TEXT("Singlethreaded"), [&SourceView]() { return ComputeImageContentHash(SourceView, true); });
+	RunBenchmark(TEXT("ParallelFor"), [&SourceView]() { return ComputeImageContentHash(SourceView, false); });
+	RunBenchmark(TEXT("TaskSystem"), [&SourceImage]() { return LaunchImageContentHash(SourceImage).GetResult(); });
+}
+
+void UThreadingSampleBPLibrary::BenchmarkWorkerBudget(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumConcurrentRequests, int32 InNumIterations)
+{
+	if (!ValidateParameters(InSourceTexture, InFilterSize, 1.0f))
+	{
+		return;
+	}
+
+	InNumConcurrentRequests = FMath::Max(InNumConcurrentRequests, 1);
+	InNumIterations = FMath::Max(InNumIterations, 1);
+
+	FSourceImageRef SourceImage = AcquireSourceImageSnapshot(InSourceTexture);
+
+	//Every request gets its own buffers, so the requests only contend for the workers. The caches are bypassed.
+	struct FRequestBuffers
+	{
+		FImageBufferRef VerticalPassResult;
+		FImageBufferRef HorizontalPassResult;
+		FImageBufferRef ScaleAlphaChannelResult;
+		FImageBufferRef CompositeResult;
+
+		static FImageView GetView(const FImageBufferRef& InBuffer)
 		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(ScaleAlphaChannelTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+			return FImageView(*InBuffer, InBuffer->RawData.GetData());
+		}
+	};
 
-	auto CompositeTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[RGBTexture = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-		AlphaTexture = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-		Result = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
+	TArray<FRequestBuffers> Buffers;
+	for (int32 Request = 0; Request < InNumConcurrentRequests; ++Request)
+	{
+		Buffers.Add({ AcquireImageBufferFromSource(InSourceTexture), AcquireImageBufferFromSource(InSourceTexture), AcquireImageBufferFromSource(InSourceTexture), AcquireImageBufferFromSource(InSourceTexture) });
+	}
+
+	//Runs the stages of the task graph pipeline as tasks: the vertical pass and the alpha scale concurrently, then the horizontal pass and the composite.
+	auto RunRequests = [&](bool InUseWorkerBudget)
 		{
-			CompositeRGBAValue(RGBTexture, AlphaTexture, Result, false);
-		},
-		UE::Tasks::Prerequisites(HorizontalPassResultUpdateTask, ScaleAlphaChannelResultUpdateTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+			TArray<UE::Tasks::FTask> CompositeTasks;
 
-	auto CompositeResultUpdateTask = UE::Tasks::Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
+			for (int32 Request = 0; Request < InNumConcurrentRequests; ++Request)
+			{
+				FFilterQoS QoS;
+				if (InUseWorkerBudget)
+				{
+					QoS.WorkerBudget = FWorkerBudget::MakeRequestBudget();
+				}
+
+				const FRequestBuffers& RequestBuffers = Buffers[Request];
+
+				auto VerticalPassTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&SourceImage, &RequestBuffers, InFilterType, InFilterSize, QoS]()
+					{
+						FilterTexture(SourceImage->GetView(), FRequestBuffers::GetView(RequestBuffers.VerticalPassResult), InFilterType, InFilterSize, EConvolutionType::OneDVertical, false, nullptr, QoS);
+					},
+					QoS.GetTaskPriority());
+
+				auto ScaleAlphaChannelTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&SourceImage, &RequestBuffers, QoS]()
+					{
+						ScaleAlphaChannel(SourceImage->GetView(), FRequestBuffers::GetView(RequestBuffers.ScaleAlphaChannelResult), 0.5f, false, nullptr, QoS);
+					},
+					QoS.GetTaskPriority());
+
+				auto HorizontalPassTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&RequestBuffers, InFilterType, InFilterSize, QoS]()
+					{
+						FilterTexture(FRequestBuffers::GetView(RequestBuffers.VerticalPassResult), FRequestBuffers::GetView(RequestBuffers.HorizontalPassResult), InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, false, nullptr, QoS);
+					},
+					UE::Tasks::Prerequisites(VerticalPassTask), QoS.GetTaskPriority());
+
+				CompositeTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [&RequestBuffers, QoS]()
+					{
+						CompositeRGBAValue(FRequestBuffers::GetView(RequestBuffers.HorizontalPassResult), FRequestBuffers::GetView(RequestBuffers.ScaleAlphaChannelResult), FRequestBuffers::GetView(RequestBuffers.CompositeResult), false, nullptr, QoS);
+					},
+					UE::Tasks::Prerequisites(HorizontalPassTask, ScaleAlphaChannelTask), QoS.GetTaskPriority()));
+			}
+
+			UE::Tasks::Wait(CompositeTasks);
+		};
+
+	double SecondsPerRun[2] = {};
+
+	for (int32 Mode = 0; Mode < 2; ++Mode)
+	{
+		const bool UseWorkerBudget = Mode == 1;
+
+		//Warm up run, also brings the pixels into memory.
+		RunRequests(UseWorkerBudget);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < InNumIterations; ++Iteration)
 		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(CompositeTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+			RunRequests(UseWorkerBudget);
+		}
 
-	OutResult = NewObject<UResultUsingTaskSystem>();
+		SecondsPerRun[Mode] = (FPlatformTime::Seconds() - StartTime) / InNumIterations;
 
-	OutResult->SetResult(CompositeResult, CompositeResultUpdateTask);
+		UE_LOG(LogThreadingSample, Display, TEXT("Worker Budget Benchmark(%s, Texture Size: %dx%d, Filter Size: %d, Concurrent Requests: %d, Workers: %d): %s, %f Seconds Per Run."),
+			EFilterTypeToString(InFilterType),
+			SourceImage->GetView().SizeX, SourceImage->GetView().SizeY, InFilterSize,
+			InNumConcurrentRequests,
+			FWorkerBudget::GetGlobal()->GetNumWorkers(),
+			UseWorkerBudget ? TEXT("Budgeted") : TEXT("Unbudgeted"),
+			SecondsPerRun[Mode]);
+	}
+
+	UE_LOG(LogThreadingSample, Display, TEXT("Worker Budget Benchmark: Budgeted runs take %.2f%% of the unbudgeted time."), 100.0 * SecondsPerRun[1] / SecondsPerRun[0]);
 }
 
-void UThreadingSampleBPLibrary::FilterTextureUsingTaskGraphSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InHoldSourceTasks, UResultUsingTaskGraphSystem*& OutResult)
+void UThreadingSampleBPLibrary::FilterTextureUsingTaskGraphSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InHoldSourceTasks, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskGraphSystem*& OutResult)
 {
 	if (!ValidateParameters(InSourceTexture, InFilterSize, InScaleValue))
 	{
@@ -222,113 +437,118 @@ void UThreadingSampleBPLibrary::FilterTextureUsingTaskGraphSystem(UTexture2D* In
 		return;
 	}
 
-	UTexture2D* VerticalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("VerticalPassResult"));
-	UTexture2D* HorizontalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("HorizontalPassResult"));
-	//We need ScaleAlphaChannelInput here because the first filter task and scale alpha channel task could overlap their execution.
-	//The calling of Lock() and Unlock() could assert in such case if we pass InSourceTexture to both tasks.
-	//We just duplicate InSourceTexture to another texture which we pass to scale alpha channel task for simplicity.
-	UTexture2D* ScaleAlphaChannelInput = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelInput"), true);
-	UTexture2D* ScaleAlphaChannelResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelResult"));
-	UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
-
-	//Construct and hold or construct and dispatch when ready.
-	//If construct and hold, the task will not start execute until we explicitly unlock it(And of course its subsequents will not execute).
-	auto VerticalPassTask = InHoldSourceTasks ?
-		TGraphTask<FTextureFilterTask>::CreateTask(
-			nullptr, ENamedThreads::GameThread).ConstructAndHold(
-				TWeakObjectPtr<UTexture2D>(InSourceTexture),
-				TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-				InFilterType, InFilterSize, EConvolutionType::OneDVertical)
-		: TGraphTask<FTextureFilterTask>::CreateTask(
-			nullptr, ENamedThreads::GameThread).ConstructAndDispatchWhenReady(
-				TWeakObjectPtr<UTexture2D>(InSourceTexture),
-				TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-				InFilterType, InFilterSize, EConvolutionType::OneDVertical);
-
-	FGraphEventArray Prerequisites1;
-	Prerequisites1.Add(VerticalPassTask);
-
-	//The predefined task type which takes a function as its task body
-	auto VerticalPassResultUpdateTask = FFunctionGraphTask::CreateAndDispatchWhenReady(
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(VerticalPassResult)]() {
-			TextureToUpdate->UpdateResource();
-		},
-		TStatId{}, &Prerequisites1, ENamedThreads::GameThread);
+	//The QoS picks the priority of every task of the request, its deadline counts from now.
+	FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture,
+		{ InFilterType, InFilterSize, InScaleValue, EIntermediatePrecision::EightBit, FFilterQoS::Make(InQoS, InDeadlineSeconds) });
 
-	FGraphEventArray Prerequisites2;
-	Prerequisites2.Add(VerticalPassResultUpdateTask);
+	//Every node is a TGraphTask. If InHoldSourceTasks, the tasks reading the source are constructed and held,
+	//they will not start execute until the whole request is set up(And of course their subsequents will not execute).
+	Request->Launch(EFilterPipelineBackend::TaskGraph, nullptr, InHoldSourceTasks);
 
-	auto HorizontalPassTask = TGraphTask<FTextureFilterTask>::CreateTask(
-		&Prerequisites2, ENamedThreads::GameThread).ConstructAndDispatchWhenReady(
-			TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-			TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-			InFilterType, InFilterSize, EConvolutionType::OneDHorizontal);
+	OutResult = NewObject<UResultUsingTaskGraphSystem>();
 
-	FGraphEventArray Prerequisites3;
-	Prerequisites3.Add(HorizontalPassTask);
+	//Canceled through the result object.
+	OutResult->SetResult(Request->GetResult(), Request->GetCompletionEvent(), Request->GetCancellation());
 
-	//The predefined task type which takes a function as its task body
-	auto HorizontalPassResultUpdateTask = FFunctionGraphTask::CreateAndDispatchWhenReady(
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(HorizontalPassResult)]() {
-			TextureToUpdate->UpdateResource();
-		},
-		TStatId{}, &Prerequisites3, ENamedThreads::GameThread);
-
-	auto ScaleAlphaChannelTask = InHoldSourceTasks ?
-		TGraphTask<FScaleAlphaChannelTask>::CreateTask(
-			nullptr, ENamedThreads::GameThread).ConstructAndHold(
-				TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelInput),
-				TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-				InScaleValue)
-		: TGraphTask<FScaleAlphaChannelTask>::CreateTask(
-			nullptr, ENamedThreads::GameThread).ConstructAndDispatchWhenReady(
-				TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelInput),
-				TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-				InScaleValue);
-
-	FGraphEventArray Prerequisites4;
-	Prerequisites4.Add(ScaleAlphaChannelTask);
-
-	//The predefined task type which takes a function as its task body
-	auto ScaleAlphaChannelResultUpdateTask = FFunctionGraphTask::CreateAndDispatchWhenReady(
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult)]() {
-			TextureToUpdate->UpdateResource();
-		},
-		TStatId{}, &Prerequisites4, ENamedThreads::GameThread);
+	//Runs alongside the full resolution pipeline and arrives first through the same result object.
+	if (InProgressivePreview && ShouldLaunchFilterPreview(InSourceTexture))
+	{
+		OutResult->SetPreview(LaunchFilterPreview(InSourceTexture, Request->GetSourceImage(), InFilterType, InFilterSize, InScaleValue, Request->GetCancellation(), MakeTaskFromGraphEvent(Request->GetCompletionEvent())));
+	}
+}
+
+void UThreadingSampleBPLibrary::FilterTextureUsingPipe(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingPipe*& OutResult)
+{
+	if (!ValidateParameters(InSourceTexture, InFilterSize, InScaleValue))
+	{
+		OutResult = nullptr;
+		return;
+	}
 
-	FGraphEventArray Prerequisites5;
-	Prerequisites5.Add(HorizontalPassResultUpdateTask);
-	Prerequisites5.Add(ScaleAlphaChannelResultUpdateTask);
+	//The QoS picks the priority of every task of the request, its deadline counts from now.
+	FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture,
+		{ InFilterType, InFilterSize, InScaleValue, EIntermediatePrecision::EightBit, FFilterQoS::Make(InQoS, InDeadlineSeconds) });
 
-	auto CompositeTask = TGraphTask<FCompositeRGBAValueTask>::CreateTask(
-		&Prerequisites5, ENamedThreads::GameThread).ConstructAndDispatchWhenReady(
-			HorizontalPassResult,
-			ScaleAlphaChannelResult,
-			CompositeResult);
+	//We are launching tasks through FPipe, one per lane of the graph.
+	FFilterPipelinePipes Pipes = MakeFilterPipelinePipes(FFilterPipelineGraph::GetDefault());
 
-	FGraphEventArray Prerequisites6;
-	Prerequisites6.Add(CompositeTask);
+	//The tasks of a lane run one after another through its pipe, the lanes(and other pipelines reading the same source) run at the same time.
+	Request->Launch(EFilterPipelineBackend::Pipe, &Pipes);
 
-	//The predefined task type which takes a function as its task body
-	auto CompositeResultUpdateTask = FFunctionGraphTask::CreateAndDispatchWhenReady(
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(CompositeResult)]() {
-			TextureToUpdate->UpdateResource();
+	OutResult = NewObject<UResultUsingPipe>();
+
+	//Canceled through the result object.
+	OutResult->SetResult(Request->GetResult(), MoveTemp(Pipes), Request->GetCompletionTask(), Request->GetCancellation());
+
+	//Runs alongside the piped tasks(not through the pipe, it would wait for them otherwise) and arrives first through the same result object.
+	if (InProgressivePreview && ShouldLaunchFilterPreview(InSourceTexture))
+	{
+		OutResult->SetPreview(LaunchFilterPreview(InSourceTexture, Request->GetSourceImage(), InFilterType, InFilterSize, InScaleValue, Request->GetCancellation(), Request->GetCompletionTask()));
+	}
+}
+
+//Suspends at every co_await without blocking a thread. After a task it resumes through an inline continuation on the thread that completed the task(see TTaskAwaiter),
+//BenchmarkCoroutine() compares the cost with the per node tasks. The request only provides the source snapshot, the parameters, the result cache lookup and the cancellation,
+//none of its nodes are launched.
+static FTaskCoroutine FilterTextureCoroutine(FFilterPipelineRequestRef InRequest, FTransientTextureTask InResultTexture)
+{
+	const FFilterPipelineParameters& Parameters = InRequest->GetParameters();
+	const UE::Tasks::FCancellationToken* CancellationToken = InRequest->GetCancellation()->GetToken().Get();
+	UTexture2D* SourceTexture = InRequest->GetSourceImage()->GetTexture();
+
+	//Leased on the game thread, like the buffers of the other pipelines.
+	FImageBufferRef VerticalPassResult = AcquireIntermediateImageBuffer(SourceTexture, Parameters.IntermediatePrecision);
+	FImageBufferRef BlurResult = AcquireImageBufferFromSource(SourceTexture);
+	FImageBufferRef ScaleAlphaResult = AcquireImageBufferFromSource(SourceTexture);
+
+	//The source is hashed by tasks. Identical requests hand back the cached texture without filtering(see FilterTextureUsingCoroutine()).
+	const FTransientTextureRef CachedResult = co_await InRequest->GetCachedResult();
+	if (CachedResult.IsValid())
+	{
+		co_return;
+	}
+
+	//Independent of the blur, so it runs as a task of its own while the coroutine runs the blur.
+	UE::Tasks::FTask ScaleAlphaTask = UE::Tasks::Launch(
+		TEXT("ScaleAlpha"),
+		[Source = FTaskImage(InRequest->GetSourceImage()), Result = FTaskImage(ScaleAlphaResult), &Parameters, CancellationToken]()
+		{
+			ScaleAlphaChannel(Source, Result, Parameters.ScaleValue, false, CancellationToken, Parameters.QoS);
 		},
-		TStatId{}, &Prerequisites6, ENamedThreads::GameThread);
+		Parameters.QoS.GetTaskPriority(),
+		UE::Tasks::EExtendedTaskPriority::None
+	);
+
+	//Leaves the game thread(if the lookup did not already). Both 1D passes run on this worker(and go wide through their loops) without a task per pass.
+	co_await ResumeInBackground(Parameters.QoS.GetTaskPriority());
+
+	FilterTexture(FTaskImage(InRequest->GetSourceImage()), FTaskImage(VerticalPassResult), Parameters.FilterType, Parameters.FilterSize, EConvolutionType::OneDVertical, false, CancellationToken, Parameters.QoS);
+	FilterTexture(FTaskImage(VerticalPassResult), FTaskImage(BlurResult), Parameters.FilterType, Parameters.FilterSize, EConvolutionType::OneDHorizontal, false, CancellationToken, Parameters.QoS);
+
+	//Usually done by now(no suspension then), the result texture is created asynchronously on the game thread.
+	co_await ScaleAlphaTask;
+	const FTransientTextureRef ResultTexture = co_await InResultTexture;
 
-	if (InHoldSourceTasks)
+	CompositeRGBAValue(FTaskImage(BlurResult), FTaskImage(ScaleAlphaResult), FTaskImage(InResultTexture), false, CancellationToken, Parameters.QoS);
+
+	//Back to the game thread for the upload, through the finalize queue like the other pipelines.
+	co_await ResumeOnFinalizeQueue();
+
+	//The texture of a canceled request is neither uploaded nor cached. It is null if the source was garbage collected before it was created.
+	if (InRequest->GetCancellation()->IsCanceled() || !ResultTexture.IsValid())
 	{
-		//Let the task begin execute(Let the scheduler schedule the task to be executed on a worker thread).
-		VerticalPassTask->Unlock();
-		ScaleAlphaChannelTask->Unlock();
+		co_return;
 	}
 
-	OutResult = NewObject<UResultUsingTaskGraphSystem>();
+	UploadTextureRegions(ResultTexture->GetTexture());
 
-	OutResult->SetResult(CompositeResult, CompositeResultUpdateTask);
+	if (InRequest->GetCacheKey())
+	{
+		FFilterResultCache::Get().Add(*InRequest->GetCacheKey(), ResultTexture);
+	}
 }
 
-void UThreadingSampleBPLibrary::FilterTextureUsingPipe(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, UResultUsingPipe*& OutResult)
+void UThreadingSampleBPLibrary::FilterTextureUsingCoroutine(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskSystem*& OutResult)
 {
 	if (!ValidateParameters(InSourceTexture, InFilterSize, InScaleValue))
 	{
@@ -336,114 +556,142 @@ void UThreadingSampleBPLibrary::FilterTextureUsingPipe(UTexture2D* InSourceTextu
 		return;
 	}
 
-	UTexture2D* VerticalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("VerticalPassResult"));
-	UTexture2D* HorizontalPassResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("HorizontalPassResult"));
-	//We dont need this anymore, as we are launching tasks through FPipe(The DAG becomes a chain of tasks).
-	// UTexture2D* ScaleAlphaChannelInput = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelInput"), true);
-	UTexture2D* ScaleAlphaChannelResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("ScaleAlphaChannelResult"));
-	UTexture2D* CompositeResult = CreateTransientTextureFromSource(InSourceTexture, TEXT("CompositeResult"));
+	//Takes the source snapshot and launches the result cache lookup, its nodes are never launched.
+	FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture,
+		{ InFilterType, InFilterSize, InScaleValue, InIntermediatePrecision, FFilterQoS::Make(InQoS, InDeadlineSeconds) });
 
-	//We are launching tasks through FPipe.
-	TUniquePtr<UE::Tasks::FPipe> Pipe = MakeUnique<UE::Tasks::FPipe>(TEXT("TextureFilterPipe"));
+	FTransientTextureTask ResultTexture = CreateTransientTextureFromSourceAsync(InSourceTexture, TEXT("CompositeResult"));
 
-	auto VerticalPassTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(InSourceTexture),
-		FilteredResult = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-		InFilterType, InFilterSize]()
-		{
-			FilterTexture(SourceTexture, FilteredResult, InFilterType, InFilterSize, EConvolutionType::OneDVertical, false);
-		},
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+	//Runs up to its first co_await right here, on the game thread.
+	const UE::Tasks::FTask CompletionTask = FilterTextureCoroutine(Request, ResultTexture).GetTask();
+
+	//Batch work yields while the request is in flight.
+	if (InQoS == EFilterQoS::Interactive)
+	{
+		TrackInteractiveRequest(CompletionTask);
+	}
 
-	auto VerticalPassResultUpdateTask = Pipe->Launch(
+	//The cached result if the coroutine found one, the texture it wrote otherwise. Completed after the coroutine, so it is the task handle of the result object as well.
+	FTransientTextureTask Result = UE::Tasks::Launch(
 		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(VerticalPassResult)]()
+		[CachedResult = Request->GetCachedResult(), ResultTexture]() mutable -> FTransientTextureRef
 		{
-			TextureToUpdate->UpdateResource();
+			const FTransientTextureRef& Cached = CachedResult.GetResult();
+			return Cached.IsValid() ? Cached : ResultTexture.GetResult();
 		},
-		UE::Tasks::Prerequisites(VerticalPassTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
+		UE::Tasks::Prerequisites(CompletionTask, ResultTexture),
+		LowLevelTasks::ETaskPriority::High,
+		UE::Tasks::EExtendedTaskPriority::Inline
 	);
 
-	auto HorizontalPassTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(VerticalPassResult),
-		FilteredResult = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-		InFilterType, InFilterSize]()
-		{
+	OutResult = NewObject<UResultUsingTaskSystem>();
 
-			FilterTexture(SourceTexture, FilteredResult, InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, false);
-		},
-		UE::Tasks::Prerequisites(VerticalPassResultUpdateTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+	//Canceled through the result object.
+	OutResult->SetResult(Result, Result, Request->GetCancellation());
 
-	auto HorizontalPassResultUpdateTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(HorizontalPassResult)]()
-		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(HorizontalPassTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+	//Runs alongside the coroutine and arrives first through the same result object.
+	if (InProgressivePreview && ShouldLaunchFilterPreview(InSourceTexture))
+	{
+		OutResult->SetPreview(LaunchFilterPreview(InSourceTexture, Request->GetSourceImage(), InFilterType, InFilterSize, InScaleValue, Request->GetCancellation(), CompletionTask));
+	}
+}
 
-	auto ScaleAlphaChannelTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[SourceTexture = TWeakObjectPtr<UTexture2D>(/*ScaleAlphaChannelInput*/InSourceTexture),
-		ScaledResult = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-		InScaleValue]()
+void UThreadingSampleBPLibrary::BenchmarkCoroutine(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumIterations)
+{
+	if (!ValidateParameters(InSourceTexture, InFilterSize, 1.0f))
+	{
+		return;
+	}
+
+	InNumIterations = FMath::Max(InNumIterations, 1);
+
+	//Every run does the whole work, so the caches are bypassed(neither is looked up and the source is not hashed). The per request profile would only add to the node tasks.
+	const TCHAR* DisabledVariables[] = { TEXT("ThreadingSample.ResultCache.Enable"), TEXT("ThreadingSample.StageCache.Enable"), TEXT("ThreadingSample.Pipeline.Profile") };
+	TArray<TPair<IConsoleVariable*, bool>, TInlineAllocator<UE_ARRAY_COUNT(DisabledVariables)>> RestoredVariables;
+
+	for (const TCHAR* Name : DisabledVariables)
+	{
+		if (IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name))
 		{
-			ScaleAlphaChannel(SourceTexture, ScaledResult, InScaleValue, false);
-		},
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+			RestoredVariables.Emplace(Variable, Variable->GetBool());
+			Variable->Set(false, ECVF_SetByCode);
+		}
+	}
 
-	auto ScaleAlphaChannelResultUpdateTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult)]()
+	const FFilterPipelineParameters Parameters{ InFilterType, InFilterSize, 0.5f, EIntermediatePrecision::EightBit, FFilterQoS::Make(EFilterQoS::Normal, 0.0f) };
+
+	//The uploads go through the finalize queue and new textures are created by game thread tasks, both are pumped here instead of waiting for the next frame.
+	auto WaitOnGameThread = [](const UE::Tasks::FTask& InTask)
 		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(ScaleAlphaChannelTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+			while (!InTask.IsCompleted())
+			{
+				FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+				FGameThreadFinalizeQueue::Get().Tick(0.0f);
+			}
+		};
 
-	auto CompositeTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[RGBTexture = TWeakObjectPtr<UTexture2D>(HorizontalPassResult),
-		AlphaTexture = TWeakObjectPtr<UTexture2D>(ScaleAlphaChannelResult),
-		Result = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
+	//One request at a time from setup to upload, so the time per run is the latency of a request. The result textures go back to the pool after every run.
+	auto RunRequest = [&](bool InUseCoroutine)
 		{
-			CompositeRGBAValue(RGBTexture, AlphaTexture, Result, false);
-		},
-		UE::Tasks::Prerequisites(HorizontalPassResultUpdateTask, ScaleAlphaChannelResultUpdateTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::None
-	);
+			FFilterPipelineRequestRef Request = FFilterPipelineRequest::Create(FFilterPipelineGraph::GetDefault(), InSourceTexture, Parameters);
 
-	auto CompositeResultUpdateTask = Pipe->Launch(
-		UE_SOURCE_LOCATION,
-		[TextureToUpdate = TWeakObjectPtr<UTexture2D>(CompositeResult)]()
+			if (InUseCoroutine)
+			{
+				WaitOnGameThread(FilterTextureCoroutine(Request, CreateTransientTextureFromSourceAsync(InSourceTexture, TEXT("CompositeResult"))).GetTask());
+			}
+			else
+			{
+				Request->Launch(EFilterPipelineBackend::Tasks);
+				WaitOnGameThread(Request->GetCompletionTask());
+			}
+		};
+
+	double SecondsPerRun[2] = {};
+
+	for (int32 Mode = 0; Mode < 2; ++Mode)
+	{
+		const bool UseCoroutine = Mode == 1;
+
+		//Warm up run, also fills the texture and image buffer pools.
+		RunRequest(UseCoroutine);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < InNumIterations; ++Iteration)
 		{
-			TextureToUpdate->UpdateResource();
-		},
-		UE::Tasks::Prerequisites(CompositeTask),
-		LowLevelTasks::ETaskPriority::BackgroundHigh,
-		UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri //Executed on GameThread.
-	);
+			RunRequest(UseCoroutine);
+		}
 
-	OutResult = NewObject<UResultUsingPipe>();
+		SecondsPerRun[Mode] = (FPlatformTime::Seconds() - StartTime) / InNumIterations;
+
+		UE_LOG(LogThreadingSample, Display, TEXT("Coroutine Benchmark(%s, Texture Size: %dx%d, Filter Size: %d): %s, %f Seconds Per Run."),
+			EFilterTypeToString(InFilterType),
+			InSourceTexture->GetSizeX(), InSourceTexture->GetSizeY(), InFilterSize,
+			UseCoroutine ? TEXT("Coroutine") : TEXT("Task System"),
+			SecondsPerRun[Mode]);
+	}
+
+	UE_LOG(LogThreadingSample, Display, TEXT("Coroutine Benchmark: Coroutine runs take %.2f%% of the task system time."), 100.0 * SecondsPerRun[1] / SecondsPerRun[0]);
+
+	for (const TPair<IConsoleVariable*, bool>& Variable : RestoredVariables)
+	{
+		Variable.Key->Set(Variable.Value, ECVF_SetByCode);
+	}
+}
+
+void UThreadingSampleBPLibrary::FilterTexturesInBatch(const TArray<UTexture2D*>& InSourceTextures, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, int32 InMaxConcurrency, UBatchFilterResult*& OutResult)
+{
+	for (UTexture2D* SourceTexture : InSourceTextures)
+	{
+		if (!ValidateParameters(SourceTexture, InFilterSize, InScaleValue))
+		{
+			OutResult = nullptr;
+			return;
+		}
+	}
 
-	OutResult->SetResult(CompositeResult, MoveTemp(Pipe));
+	OutResult = NewObject<UBatchFilterResult>();
+	OutResult->SetBatch(FBatchTextureFilter::Launch(InSourceTextures, { InFilterType, InFilterSize, InScaleValue, InIntermediatePrecision, InMaxConcurrency }), InSourceTextures);
 }
 
 /*----------------------------------------------------------------------------------
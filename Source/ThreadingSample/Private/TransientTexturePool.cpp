@@ -0,0 +1,176 @@
+#include "TransientTexturePool.h"
+
+#include "Engine/Texture2D.h"
+
+static TAutoConsoleVariable<int32> CVarTransientTexturePoolMaxMemoryMB(
+	TEXT("ThreadingSample.TexturePool.MaxMemoryMB"),
+	256,
+	TEXT("Memory budget of the transient texture pool in MB. Idle textures are evicted(least recently returned first) while the pool exceeds it.\n")
+	TEXT("Leased textures are never evicted, so the pool can temporarily exceed the budget."),
+	ECVF_Default);
+
+int64 FTransientTextureKey::GetSizeInBytes() const
+{
+	const FPixelFormatInfo& FormatInfo = GPixelFormats[PixelFormat];
+	const int64 NumBlocksX = FMath::DivideAndRoundUp(SizeX, FormatInfo.BlockSizeX);
+	const int64 NumBlocksY = FMath::DivideAndRoundUp(SizeY, FormatInfo.BlockSizeY);
+	return NumBlocksX * NumBlocksY * FormatInfo.BlockBytes;
+}
+
+FTransientTextureLease::~FTransientTextureLease()
+{
+	if (Texture)
+	{
+		//A Blueprint may still show or write an exposed texture, handing it out again would change it under its feet.
+		if (bExposed.load(std::memory_order_relaxed))
+		{
+			FTransientTexturePool::Get().Forget(Texture, Key);
+		}
+		else
+		{
+			FTransientTexturePool::Get().Return(Texture, Key);
+		}
+	}
+}
+
+UTexture2D* FTransientTextureLease::Detach()
+{
+	UTexture2D* DetachedTexture = Texture;
+
+	if (Texture)
+	{
+		FTransientTexturePool::Get().Forget(Texture, Key);
+		Texture = nullptr;
+	}
+
+	return DetachedTexture;
+}
+
+FTransientTexturePool& FTransientTexturePool::Get()
+{
+	//Intentionally leaked(like the thread pool wrappers) so it is never destroyed after the UObject system during shutdown.
+	static FTransientTexturePool* GTransientTexturePool = new FTransientTexturePool;
+	return *GTransientTexturePool;
+}
+
+FTransientTextureRef FTransientTexturePool::TryAcquireIdle(const FTransientTextureKey& InKey)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	//A returned texture is only handed out again once the render thread has moved past the frame it was returned in.
+	//Otherwise a pending upload(UpdateResource() or UploadTextureRegions()) could read the pixels of the next lease.
+	for (int32 Index = IdleTextures.Num() - 1; Index >= 0; --Index)
+	{
+		const FIdleTexture& IdleTexture = IdleTextures[Index];
+		if (IdleTexture.Key == InKey && IdleTexture.ReturnFrame < GFrameCounterRenderThread)
+		{
+			UTexture2D* Texture = IdleTexture.Texture;
+			IdleTextures.RemoveAt(Index);
+			LeasedTextures.Add(Texture);
+
+			return MakeShareable(new FTransientTextureLease(Texture, InKey));
+		}
+	}
+
+	return nullptr;
+}
+
+FTransientTextureRef FTransientTexturePool::Acquire(const FTransientTextureKey& InKey, const FString& InDebugName)
+{
+	if (FTransientTextureRef IdleTexture = TryAcquireIdle(InKey))
+	{
+		return IdleTexture;
+	}
+
+	check(IsInGameThread());
+
+	const FName TextureName = MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), FName(*InDebugName));
+	UTexture2D* Texture = UTexture2D::CreateTransient(InKey.SizeX, InKey.SizeY, InKey.PixelFormat, TextureName);
+	check(Texture);
+	Texture->SRGB = InKey.bSRGB;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		LeasedTextures.Add(Texture);
+		PooledBytes += InKey.GetSizeInBytes();
+
+		//Make room for the new texture.
+		TrimLocked(int64(CVarTransientTexturePoolMaxMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+	}
+
+	return MakeShareable(new FTransientTextureLease(Texture, InKey));
+}
+
+void FTransientTexturePool::Return(UTexture2D* InTexture, const FTransientTextureKey& InKey)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	verify(LeasedTextures.RemoveSingleSwap(InTexture) == 1);
+	IdleTextures.Add({ InKey, InTexture, GFrameCounter });
+
+	TrimLocked(int64(CVarTransientTexturePoolMaxMemoryMB.GetValueOnAnyThread()) * 1024 * 1024);
+}
+
+void FTransientTexturePool::Forget(UTexture2D* InTexture, const FTransientTextureKey& InKey)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	verify(LeasedTextures.RemoveSingleSwap(InTexture) == 1);
+	PooledBytes -= InKey.GetSizeInBytes();
+}
+
+void FTransientTexturePool::Trim(int64 InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	TrimLocked(InMaxBytes);
+}
+
+void FTransientTexturePool::TrimLocked(int64 InMaxBytes)
+{
+	int32 NumEvicted = 0;
+	while (PooledBytes > InMaxBytes && NumEvicted < IdleTextures.Num())
+	{
+		//Once unreferenced by the pool the texture will be collected by GC.
+		PooledBytes -= IdleTextures[NumEvicted].Key.GetSizeInBytes();
+		++NumEvicted;
+	}
+
+	if (NumEvicted > 0)
+	{
+		IdleTextures.RemoveAt(0, NumEvicted);
+
+		UE_LOG(LogThreadingSample, Verbose, TEXT("Transient texture pool evicted %d idle textures (Pooled: %lld bytes, Budget: %lld bytes)."), NumEvicted, PooledBytes, InMaxBytes);
+	}
+}
+
+int64 FTransientTexturePool::GetPooledBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return PooledBytes;
+}
+
+int32 FTransientTexturePool::GetNumIdleTextures() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return IdleTextures.Num();
+}
+
+int32 FTransientTexturePool::GetNumLeasedTextures() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return LeasedTextures.Num();
+}
+
+void FTransientTexturePool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	//Leases can be returned from worker threads while GC gathers references.
+	FScopeLock Lock(&CriticalSection);
+
+	for (FIdleTexture& IdleTexture : IdleTextures)
+	{
+		Collector.AddReferencedObject(IdleTexture.Texture);
+	}
+
+	Collector.AddReferencedObjects(LeasedTextures);
+}
@@ -0,0 +1,137 @@
+#include "WavefrontFilter.h"
+#include "LinearImageCache.h"
+
+static TAutoConsoleVariable<int32> CVarWavefrontFilterRowsPerBand(
+	TEXT("ThreadingSample.WavefrontFilter.RowsPerBand"),
+	32,
+	TEXT("Rows filtered by one band task of the wavefront filter. Smaller bands start the horizontal pass earlier but cost more tasks."),
+	ECVF_Default);
+
+UE::Tasks::FTask LaunchWavefrontFilter(FSourceImageRef InSource, TOptional<uint64> InSourceHash, FImageBufferRef InVerticalPassResult, FImageBufferRef OutFiltered, EFilterType InFilterType, int32 InFilterSize, FCancellationTokenPtr InCancellationToken, const FFilterQoS& InQoS)
+{
+	const FImageView& SourceView = InSource->GetView();
+	check(SourceView.SizeX == InVerticalPassResult->SizeX && SourceView.SizeY == InVerticalPassResult->SizeY);
+	check(SourceView.SizeX == OutFiltered->SizeX && SourceView.SizeY == OutFiltered->SizeY);
+
+	//Everything allocated while setting up the bands is released when this function returns.
+	FMemMark Mark(FMemStack::Get());
+
+	//How many rows of the vertical pass result a horizontal band reads above and below its own rows.
+	//Zero for a 1D horizontal kernel, so a horizontal band only waits for the vertical band with the same rows.
+	int32 HorizontalApron = 0;
+	{
+		FFilterWeights HorizontalWeights;
+		FFilterOffsets HorizontalOffsets;
+		ComputeFilterKernel(InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, HorizontalWeights, HorizontalOffsets);
+
+		for (const FIntPoint& Offset : HorizontalOffsets)
+		{
+			HorizontalApron = FMath::Max(HorizontalApron, FMath::Abs(Offset.Y));
+		}
+	}
+
+	//The vertical pass reads the linear copy of the source, decoded once and shared by later requests on the same pixels.
+	const FLinearSourceImage LinearSource = FLinearImageCache::Get().Acquire(InSource, InSourceHash);
+
+	const int32 TextureHeight = SourceView.SizeY;
+	const int32 RowsPerBand = FMath::Max(CVarWavefrontFilterRowsPerBand.GetValueOnAnyThread(), 1);
+	const int32 NumBands = FMath::DivideAndRoundUp(TextureHeight, RowsPerBand);
+
+	//Picked once for the whole wavefront, a batch wavefront launched past its deadline is promoted as a whole.
+	const LowLevelTasks::ETaskPriority QoSPriority = InQoS.GetTaskPriority();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<UE::Tasks::FTask, TMemStackAllocator<>> VerticalBands;
+	VerticalBands.Reserve(NumBands);
+
+	for (int32 Band = 0; Band < NumBands; ++Band)
+	{
+		const int32 FirstRow = Band * RowsPerBand;
+		const int32 NumRows = FMath::Min(RowsPerBand, TextureHeight - FirstRow);
+
+		//The linear source is immutable once decoded, vertical bands only wait for the decode(if it is not cached already).
+		VerticalBands.Add(UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[LinearSource, InVerticalPassResult, InFilterType, InFilterSize, FirstRow, NumRows, InCancellationToken, InQoS]()
+			{
+				//Yielding and cancellation are checked per band.
+				InQoS.YieldToInteractiveWork(InCancellationToken.Get());
+
+				if (InCancellationToken && InCancellationToken->IsCanceled())
+				{
+					return;
+				}
+
+				//A 1D kernel is a handful of taps, every band computes its own on the FMemStack of its worker.
+				FMemMark Mark(FMemStack::Get());
+
+				FFilterWeights Weights;
+				FFilterOffsets Offsets;
+				ComputeFilterKernel(InFilterType, InFilterSize, EConvolutionType::OneDVertical, Weights, Offsets);
+
+				const FImageView VerticalPassResultView(*InVerticalPassResult, InVerticalPassResult->RawData.GetData());
+				FilterTextureRows(LinearSource.GetView(), VerticalPassResultView, Weights, Offsets, FirstRow, NumRows);
+			},
+			UE::Tasks::Prerequisites(LinearSource.DecodeTask),
+			QoSPriority,
+			UE::Tasks::EExtendedTaskPriority::None
+		));
+	}
+
+	TArray<UE::Tasks::FTask, TMemStackAllocator<>> HorizontalBands;
+	HorizontalBands.Reserve(NumBands);
+
+	for (int32 Band = 0; Band < NumBands; ++Band)
+	{
+		const int32 FirstRow = Band * RowsPerBand;
+		const int32 NumRows = FMath::Min(RowsPerBand, TextureHeight - FirstRow);
+
+		const int32 FirstDependency = FMath::Max(FirstRow - HorizontalApron, 0) / RowsPerBand;
+		const int32 LastDependency = FMath::Min(FirstRow + NumRows - 1 + HorizontalApron, TextureHeight - 1) / RowsPerBand;
+
+		TArray<UE::Tasks::FTask, TMemStackAllocator<>> Dependencies(&VerticalBands[FirstDependency], LastDependency - FirstDependency + 1);
+
+		HorizontalBands.Add(UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[InVerticalPassResult, OutFiltered, InFilterType, InFilterSize, FirstRow, NumRows, InCancellationToken, InQoS]()
+			{
+				InQoS.YieldToInteractiveWork(InCancellationToken.Get());
+
+				if (InCancellationToken && InCancellationToken->IsCanceled())
+				{
+					return;
+				}
+
+				FMemMark Mark(FMemStack::Get());
+
+				FFilterWeights Weights;
+				FFilterOffsets Offsets;
+				ComputeFilterKernel(InFilterType, InFilterSize, EConvolutionType::OneDHorizontal, Weights, Offsets);
+
+				const FImageView VerticalPassResultView(*InVerticalPassResult, InVerticalPassResult->RawData.GetData());
+				const FImageView FilteredView(*OutFiltered, OutFiltered->RawData.GetData());
+				FilterTextureRows(VerticalPassResultView, FilteredView, Weights, Offsets, FirstRow, NumRows);
+			},
+			UE::Tasks::Prerequisites(Dependencies),
+			QoSPriority,
+			UE::Tasks::EExtendedTaskPriority::None
+		));
+	}
+
+	//Joins the horizontal bands, executed by whichever worker completes the last one.
+	return UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[InFilterType, InFilterSize, Width = SourceView.SizeX, TextureHeight, NumBands, StartTime, InCancellationToken]()
+		{
+			UE_LOG(LogThreadingSample, Display, TEXT("Wavefront %s(Texture Size: %dx%d, Filter Size: %d, Bands: %d) Execution %s in %f Seconds."),
+				EFilterTypeToString(InFilterType),
+				Width, TextureHeight, InFilterSize, NumBands,
+				InCancellationToken && InCancellationToken->IsCanceled() ? TEXT("Canceled") : TEXT("Finished"),
+				FPlatformTime::Seconds() - StartTime);
+		},
+		UE::Tasks::Prerequisites(HorizontalBands),
+		QoSPriority,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+}
@@ -0,0 +1,91 @@
+#include "WorkerBudget.h"
+
+static TAutoConsoleVariable<int32> CVarWorkerBudgetGlobal(
+	TEXT("ThreadingSample.WorkerBudget.Global"),
+	0,
+	TEXT("Workers shared by the loops of all texture filter requests. 0 uses the number of task workers. Read once, when the first request starts."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarWorkerBudgetPerRequest(
+	TEXT("ThreadingSample.WorkerBudget.PerRequest"),
+	0,
+	TEXT("Workers shared by the loops of one texture filter request. 0 uses the global budget."),
+	ECVF_Default);
+
+FWorkerBudget::FWorkerBudget(int32 InNumWorkers, TSharedPtr<FWorkerBudget, ESPMode::ThreadSafe> InParent)
+	:NumWorkers(FMath::Max(InNumWorkers, 1)), Parent(MoveTemp(InParent)), NumIdleHelpers(FMath::Max(InNumWorkers, 1) - 1)
+{
+}
+
+const TSharedRef<FWorkerBudget, ESPMode::ThreadSafe>& FWorkerBudget::GetGlobal()
+{
+	static const TSharedRef<FWorkerBudget, ESPMode::ThreadSafe> GlobalBudget = MakeShared<FWorkerBudget, ESPMode::ThreadSafe>(
+		CVarWorkerBudgetGlobal.GetValueOnAnyThread() > 0 ? CVarWorkerBudgetGlobal.GetValueOnAnyThread() : int32(LowLevelTasks::FScheduler::Get().GetNumWorkers()));
+
+	return GlobalBudget;
+}
+
+TSharedRef<FWorkerBudget, ESPMode::ThreadSafe> FWorkerBudget::MakeRequestBudget()
+{
+	const TSharedRef<FWorkerBudget, ESPMode::ThreadSafe>& GlobalBudget = GetGlobal();
+
+	const int32 PerRequest = CVarWorkerBudgetPerRequest.GetValueOnAnyThread();
+
+	return MakeShared<FWorkerBudget, ESPMode::ThreadSafe>(PerRequest > 0 ? FMath::Min(PerRequest, GlobalBudget->GetNumWorkers()) : GlobalBudget->GetNumWorkers(), GlobalBudget);
+}
+
+int32 FWorkerBudget::Acquire(int32 InMaxWorkers)
+{
+	return 1 + AcquireHelpers(InMaxWorkers - 1);
+}
+
+void FWorkerBudget::Release(int32 InNumWorkers)
+{
+	check(InNumWorkers >= 1);
+
+	ReleaseHelpers(InNumWorkers - 1);
+}
+
+int32 FWorkerBudget::AcquireHelpers(int32 InMaxHelpers)
+{
+	const int32 NumLoops = NumActiveLoops.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	//The fair share of this loop, rounded up so a lone loop gets the whole budget.
+	const int32 MaxHelpers = FMath::Min(InMaxHelpers, FMath::DivideAndRoundUp(NumWorkers, NumLoops) - 1);
+
+	int32 Granted = 0;
+	int32 Idle = NumIdleHelpers.load(std::memory_order_relaxed);
+	while (MaxHelpers > 0 && Idle > 0)
+	{
+		Granted = FMath::Min(Idle, MaxHelpers);
+		if (NumIdleHelpers.compare_exchange_weak(Idle, Idle - Granted, std::memory_order_relaxed))
+		{
+			break;
+		}
+		Granted = 0;
+	}
+
+	//The loop is counted by the parent too(even without helpers), so its fair share accounts for the loops of every request.
+	//The parent may have less left than this budget, give back what it cannot cover.
+	if (Parent.IsValid())
+	{
+		const int32 GrantedByParent = Parent->AcquireHelpers(Granted);
+		NumIdleHelpers.fetch_add(Granted - GrantedByParent, std::memory_order_relaxed);
+		Granted = GrantedByParent;
+	}
+
+	return Granted;
+}
+
+void FWorkerBudget::ReleaseHelpers(int32 InNumHelpers)
+{
+	check(InNumHelpers >= 0);
+
+	if (Parent.IsValid())
+	{
+		Parent->ReleaseHelpers(InNumHelpers);
+	}
+
+	NumIdleHelpers.fetch_add(InNumHelpers, std::memory_order_relaxed);
+	NumActiveLoops.fetch_sub(1, std::memory_order_relaxed);
+}
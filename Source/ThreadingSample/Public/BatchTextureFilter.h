@@ -0,0 +1,115 @@
+#pragma once
+
+#include "TextureProcessing.h"
+#include "Tasks/TaskConcurrencyLimiter.h"
+
+//The parameters shared by every texture of a batch.
+struct FBatchFilterParameters
+{
+	EFilterType FilterType = EFilterType::BoxFilter;
+	int32 FilterSize = 3;
+	float ScaleValue = 1.0f;
+	EIntermediatePrecision IntermediatePrecision = EIntermediatePrecision::EightBit;
+
+	//Textures processed at the same time. 0 uses the number of task workers.
+	int32 MaxConcurrency = 0;
+};
+
+//Runs the blur, scale alpha and composite pipeline over many textures through a FTaskConcurrencyLimiter, for throughput rather than latency.
+//Every texture is processed by one worker from start to end(the passes do not go wide), the batch goes wide across textures instead.
+//Each concurrency slot of the limiter owns the scratch images of one texture and reuses them for every texture it processes,
+//so N textures never hold more than MaxConcurrency working sets(and source snapshots) at once, whatever N is. The pooled image buffers are not used.
+//The N result textures(each with a CPU copy of its pixels) are the output of the batch and are all leased by Launch(), so the peak memory is
+//N result images plus MaxConcurrency working sets. Leasing them later would not lower it, every result is held until the whole batch is done.
+//Runs at batch QoS: background workers at low priority, yielding to interactive requests between passes.
+class FBatchTextureFilter :public TSharedFromThis<FBatchTextureFilter, ESPMode::ThreadSafe>
+{
+public:
+	UE_NONCOPYABLE(FBatchTextureFilter);
+
+	//Use Launch().
+	FBatchTextureFilter(TConstArrayView<UTexture2D*> InSourceTextures, const FBatchFilterParameters& InParameters);
+
+	//Leases a result texture for every source texture and queues each on the limiter once its texture exists. Call on the game thread.
+	//The source textures have to pass ValidateParameters() and the caller keeps them referenced until GetCompletionTask() is completed(see UBatchFilterResult).
+	static TSharedRef<FBatchTextureFilter, ESPMode::ThreadSafe> Launch(TConstArrayView<UTexture2D*> InSourceTextures, const FBatchFilterParameters& InParameters);
+
+	//Textures that did not start yet are skipped, running ones stop at their next pass. Nothing is uploaded from now on.
+	void Cancel()
+	{
+		CancellationToken->Cancel();
+	}
+
+	bool IsCanceled() const
+	{
+		return CancellationToken->IsCanceled();
+	}
+
+	//Indexed like the source textures.
+	const TArray<FTransientTextureTask>& GetResults() const
+	{
+		return Results;
+	}
+
+	//Completed on the game thread once every texture is uploaded(or skipped).
+	const UE::Tasks::FTask& GetCompletionTask() const
+	{
+		return CompletionTask;
+	}
+
+	//Textures uploaded(or skipped) so far.
+	int32 GetNumFinished() const
+	{
+		return Results.Num() - NumPending.load(std::memory_order_relaxed);
+	}
+
+	int32 GetMaxConcurrency() const
+	{
+		return Slots.Num();
+	}
+
+private:
+	//The working set of one concurrency slot. Reinitialized only when a texture has another size or color space than the one before it.
+	struct FSlotScratch
+	{
+		FImage VerticalPassResult;
+		FImage BlurResult;
+		FImage ScaleAlphaResult;
+	};
+
+	//Runs on the worker of InSlot.
+	void ProcessTexture(int32 InIndex, uint32 InSlot);
+
+	//Uploads the result on the game thread and completes the batch after the last one.
+	void FinishTexture(int32 InIndex, bool InProcessed);
+
+	FBatchFilterParameters Parameters;
+
+	FFilterQoS QoS;
+
+	FCancellationTokenPtr CancellationToken;
+
+	//Kept alive by the caller, a texture collected anyway is skipped.
+	TArray<TWeakObjectPtr<UTexture2D>> SourceTextures;
+
+	TArray<FTransientTextureTask> Results;
+
+	TArray<FSlotScratch> Slots;
+
+	//The kernels of the vertical and horizontal passes, the same for every texture. Computed once and only read afterwards.
+	TArray<float> Weights[2];
+	TArray<FIntPoint> Offsets[2];
+
+	//Keeps its own state alive until its last task is done, so it goes away with the batch from any thread.
+	UE::Tasks::FTaskConcurrencyLimiter Limiter;
+
+	std::atomic<int32> NumPending{ 0 };
+
+	UE::Tasks::FTaskEvent CompletionEvent{ TEXT("BatchTextureFilter") };
+
+	UE::Tasks::FTask CompletionTask;
+
+	double LaunchTime = 0.0;
+};
+
+using FBatchTextureFilterRef = TSharedRef<FBatchTextureFilter, ESPMode::ThreadSafe>;
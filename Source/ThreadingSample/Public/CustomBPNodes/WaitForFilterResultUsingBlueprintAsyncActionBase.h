@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "Tasks/Task.h"
+
+#include "WaitForFilterResultUsingBlueprintAsyncActionBase.generated.h"
+
+class UResultUsingTaskSystem;
+class UResultUsingTaskGraphSystem;
+class UResultUsingPipe;
+class UBatchFilterResult;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAsyncWaitForFilterResultDelegate, UTexture2D*, Texture);
+
+//Fires once a texture filter request is finished instead of polling IsReady() on its result every frame.
+//Completion is a game thread continuation of the request(queued on FGameThreadFinalizeQueue), nothing ticks while waiting.
+//If the request has a preview, OnPreview fires with it first unless the full resolution result is finished by then.
+//The result object still owns the texture, keep it referenced for as long as the texture is used.
+UCLASS()
+class UAsyncWaitForFilterResult :public UBlueprintAsyncActionBase
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Meta = (BlueprintInternalUseOnly = "true"), Category = "Threading Sample")
+	static UAsyncWaitForFilterResult* WaitForTaskSystemResult(UResultUsingTaskSystem* InResult);
+
+	UFUNCTION(BlueprintCallable, Meta = (BlueprintInternalUseOnly = "true"), Category = "Threading Sample")
+	static UAsyncWaitForFilterResult* WaitForTaskGraphSystemResult(UResultUsingTaskGraphSystem* InResult);
+
+	UFUNCTION(BlueprintCallable, Meta = (BlueprintInternalUseOnly = "true"), Category = "Threading Sample")
+	static UAsyncWaitForFilterResult* WaitForPipeResult(UResultUsingPipe* InResult);
+
+	//A batch has no single texture. OnSuccess fires without one once every texture is uploaded, GetResults() of the batch result returns them.
+	//OnFailure fires if the batch was canceled.
+	UFUNCTION(BlueprintCallable, Meta = (BlueprintInternalUseOnly = "true"), Category = "Threading Sample")
+	static UAsyncWaitForFilterResult* WaitForBatchResult(UBatchFilterResult* InResult);
+
+public:
+	//The downsampled preview of the request, before OnSuccess.
+	UPROPERTY(BlueprintAssignable)
+	FAsyncWaitForFilterResultDelegate OnPreview;
+
+	UPROPERTY(BlueprintAssignable)
+	FAsyncWaitForFilterResultDelegate OnSuccess;
+
+	//The request was canceled(or the result is invalid).
+	UPROPERTY(BlueprintAssignable)
+	FAsyncWaitForFilterResultDelegate OnFailure;
+
+	//Succeeds if InGetTexture returns a texture, or if InIsSucceeded returns true when it is set.
+	void Start(UObject* InResult, const UE::Tasks::FTask& InCompletionTask, TFunction<UTexture2D*()> InGetTexture, TFunction<bool()> InIsSucceeded = nullptr);
+
+	//Call before Start(). Does nothing if InPreviewTask is invalid(no preview was requested).
+	void WaitForPreview(const UE::Tasks::FTask& InPreviewTask, TFunction<UTexture2D*()> InGetPreview);
+
+private:
+	void HandlePreviewFinished();
+
+	void HandleFilterFinished();
+
+	//Kept alive while waiting, it owns the leased texture.
+	UPROPERTY()
+	TObjectPtr<UObject> Result;
+
+	TFunction<UTexture2D*()> GetTexture;
+
+	TFunction<bool()> IsSucceeded;
+
+	TFunction<UTexture2D*()> GetPreview;
+
+	bool bFinished = false;
+};
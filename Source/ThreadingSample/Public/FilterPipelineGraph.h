@@ -0,0 +1,335 @@
+#pragma once
+
+#include "PipelineStageCache.h"
+#include "FilterResultCache.h"
+#include "FilterPipelineProfile.h"
+#include "Tasks/Pipe.h"
+
+//A resource read or written by the nodes of a texture filter pipeline.
+enum class EFilterPipelineResource : uint8
+{
+	Source,       //The read-only snapshot of the source texture.
+	Image,        //A pooled image buffer with the size and color space of the source(see AcquireImageBufferFromSource()).
+	Intermediate, //A pooled image buffer in the intermediate precision of the request(see AcquireIntermediateImageBuffer()).
+	ResultTexture //The leased transient texture of the result, created asynchronously(see CreateTransientTextureFromSourceAsync()).
+};
+
+//The work of one node of a texture filter pipeline.
+enum class EFilterPipelineNode : uint8
+{
+	VerticalPass,   //1D vertical pass of the blur, reads an image and writes another one.
+	HorizontalPass, //1D horizontal pass of the blur.
+	ScaleAlpha,     //Scales the alpha channel of an image.
+	Composite,      //Composites the RGB channels of its first image and the alpha channel of its second one into the result texture.
+	Finalize        //Uploads the result texture and adds it to the result cache, on the game thread through the finalize queue.
+};
+
+const TCHAR* EFilterPipelineNodeToString(EFilterPipelineNode InNode);
+
+//How the nodes of a pipeline are launched.
+enum class EFilterPipelineBackend : uint8
+{
+	Tasks,     //UE::Tasks. A vertical pass reading the source that only feeds a horizontal pass runs with it as one wavefront(see LaunchWavefrontFilter()).
+	TaskGraph, //TGraphTask. The nodes without dependencies can be held until the whole request is set up.
+	Pipe       //UE::Tasks::FPipe, one per lane of the graph. The nodes of a lane run one after another, the lanes overlap.
+};
+
+const TCHAR* EFilterPipelineBackendToString(EFilterPipelineBackend InBackend);
+
+//A texture filter pipeline described as a small CPU render graph. Built and compiled once, instantiated by every request(see FFilterPipelineRequest).
+//Every node declares the resources it reads and the one it writes, in submission order. Every resource is written by one node(a new version of an image
+//is a new resource), so Compile() infers the dependencies from the reads alone and nodes only wait for what they read, everything else overlaps.
+//Write after read and write after write hazards only come up between resources sharing a buffer, Compile() only lets them share one if the dependencies order them already.
+//The nodes of a pipeline stage(see EPipelineStage) are found in or added to the stage cache together, only the resource written last by a stage is read outside of it.
+class FFilterPipelineGraph
+{
+public:
+	static constexpr int32 MaxNodes = 8;
+	static constexpr int32 MaxResources = 8;
+	static constexpr int32 MaxReads = 2;
+	static constexpr int32 NumStages = 2; //See EPipelineStage.
+
+	struct FResource
+	{
+		EFilterPipelineResource Type = EFilterPipelineResource::Image;
+
+		//Derived by Compile().
+		//The buffer of the resource. Transient resources whose accesses are all ordered by the dependencies share one(see Compile()).
+		int8 Slot = INDEX_NONE;
+		int8 Writer = INDEX_NONE;
+		uint32 ReaderMask = 0;
+		//Kept by the stage cache beyond the request, never shares its buffer.
+		bool bRetained = false;
+	};
+
+	struct FNode
+	{
+		EFilterPipelineNode Type = EFilterPipelineNode::VerticalPass;
+
+		//The stage the node belongs to, if any.
+		TOptional<EPipelineStage> Stage;
+
+		int8 Reads[MaxReads] = { INDEX_NONE, INDEX_NONE };
+		int8 NumReads = 0;
+		int8 Write = INDEX_NONE;
+
+		//Derived by Compile().
+		//Bit N is set if the node waits for node N.
+		uint32 DependencyMask = 0;
+		//The pipe of the node for the Pipe backend. A node continues the lane of its first dependency that no other node continued.
+		int8 Lane = INDEX_NONE;
+		//The last node of its stage. Its task and the image it writes are what the stage cache keeps.
+		int8 StageOutput = INDEX_NONE;
+		bool bStageOutput = false;
+		//The first node of its stage, the stage is looked up in the stage cache before it is launched.
+		bool bStageEntry = false;
+		//A vertical pass launched together with the horizontal pass reading it by the Tasks backend.
+		bool bFusedIntoWavefront = false;
+	};
+
+	//Returns the index of the added resource.
+	int32 AddResource(EFilterPipelineResource InType);
+
+	//Returns the index of the added node. InReads and InWrite(INDEX_NONE for none) are indices of resources.
+	int32 AddNode(EFilterPipelineNode InType, std::initializer_list<int32> InReads, int32 InWrite, TOptional<EPipelineStage> InStage = {});
+
+	//Checks the accesses of every node and the layout of the stages, infers the dependencies and lanes and assigns the buffers of the resources.
+	//Logs the first problem and returns false if the graph is invalid. Nothing can be added afterwards.
+	bool Compile();
+
+	bool IsCompiled() const
+	{
+		return bCompiled;
+	}
+
+	TConstArrayView<FNode> GetNodes() const
+	{
+		return Nodes;
+	}
+
+	TConstArrayView<FResource> GetResources() const
+	{
+		return Resources;
+	}
+
+	int32 GetNumLanes() const
+	{
+		return NumLanes;
+	}
+
+	int32 GetNumSlots() const
+	{
+		return NumSlots;
+	}
+
+	//Number of reads of the resources sharing InSlot, a request releases the buffer once all of them are done.
+	int32 GetNumSlotReads(int32 InSlot) const
+	{
+		return SlotReads[InSlot];
+	}
+
+	//The blur, scale alpha and composite pipeline of the texture filter requests. Built and compiled on first use.
+	static const FFilterPipelineGraph& GetDefault();
+
+private:
+	bool IsImageResource(int32 InResourceIndex) const;
+
+	TArray<FNode, TFixedAllocator<MaxNodes>> Nodes;
+
+	TArray<FResource, TFixedAllocator<MaxResources>> Resources;
+
+	int32 NumLanes = 0;
+
+	int32 NumSlots = 0;
+
+	int8 SlotReads[MaxResources] = {};
+
+	bool bCompiled = false;
+};
+
+//The pipes of the Pipe backend, one per lane of the graph.
+using FFilterPipelinePipes = TArray<TUniquePtr<UE::Tasks::FPipe>, TInlineAllocator<FFilterPipelineGraph::MaxNodes>>;
+
+//Creates a pipe per lane of InGraph.
+FFilterPipelinePipes MakeFilterPipelinePipes(const FFilterPipelineGraph& InGraph);
+
+//Whether a task of any of InPipes is still queued or running.
+bool HasPipedWork(const FFilterPipelinePipes& InPipes);
+
+//The parameters of one request, shared by all of its nodes.
+struct FFilterPipelineParameters
+{
+	EFilterType FilterType = EFilterType::BoxFilter;
+	int32 FilterSize = 3;
+	float ScaleValue = 1.0f;
+	EIntermediatePrecision IntermediatePrecision = EIntermediatePrecision::EightBit;
+	FFilterQoS QoS;
+};
+
+//Called on the game thread once the result of a request is uploaded(not if it was canceled). Null if the result texture could not be created.
+DECLARE_DELEGATE_OneParam(FOnFilterPipelineFinalized, FTransientTextureRef);
+
+//One request running a compiled FFilterPipelineGraph. The state of all of its nodes lives in this one allocation(sized by FFilterPipelineGraph::MaxNodes),
+//the tasks of the nodes only capture a reference to it and their node index, so setting up a request allocates no per node state or lambda captures.
+//A buffer goes back to the pool as soon as the last node reading it is done, not when the request is.
+//With ThreadingSample.Pipeline.Profile every node records when and where it ran, the request is analyzed and logged once it is finalized(see FFilterPipelineProfile)
+//and shows up in Unreal Insights as a region, with another region while its finalize node waits for the game thread.
+class FFilterPipelineRequest :public TSharedFromThis<FFilterPipelineRequest, ESPMode::ThreadSafe>
+{
+public:
+	UE_NONCOPYABLE(FFilterPipelineRequest);
+
+	//Use Create().
+	FFilterPipelineRequest(const FFilterPipelineGraph& InGraph, FSourceImageRef InSourceImage, const FFilterPipelineParameters& InParameters);
+
+	//Takes the source snapshot and launches the result cache lookup(see GetCachedResult()). Launches no node.
+	static TSharedRef<FFilterPipelineRequest, ESPMode::ThreadSafe> Create(const FFilterPipelineGraph& InGraph, UTexture2D* InSourceTexture, const FFilterPipelineParameters& InParameters);
+
+	//Completed once the source is hashed(by tasks, see LaunchImageContentHash()) and the result cache was looked up.
+	//Its result is the cached result of an identical request(see FFilterResultCache), null if there is none or neither cache is enabled.
+	const UE::Tasks::TTask<FTransientTextureRef>& GetCachedResult() const
+	{
+		return CachedResult;
+	}
+
+	//Launches the nodes in order without touching the pixels. The stage cache is looked up once the result cache lookup is done and the stage entry nodes wait for it,
+	//the nodes of a stage found there(or of a request found in the result cache) skip their work and the cached stage is reused(finished or not) instead.
+	//InPipes are required by the Pipe backend(see MakeFilterPipelinePipes()). InHoldRootTasks only matters for the TaskGraph backend,
+	//the held tasks are unlocked before returning. Interactive requests are tracked until the finalize node ran(see TrackInteractiveRequest()).
+	void Launch(EFilterPipelineBackend InBackend, const FFilterPipelinePipes* InPipes = nullptr, bool InHoldRootTasks = false);
+
+	//Bind before Launch().
+	FOnFilterPipelineFinalized OnFinalized;
+
+	//Resolves to the cached result if there was one, to the texture written by the composite node otherwise. Set by Launch().
+	const FTransientTextureTask& GetResult() const
+	{
+		return ResultTexture;
+	}
+
+	//Completed after the finalize node ran. Unset for the TaskGraph backend.
+	const UE::Tasks::FTask& GetCompletionTask() const
+	{
+		return CompletionTask;
+	}
+
+	//Dispatched after the finalize node ran. Only set by the TaskGraph backend.
+	const FGraphEventRef& GetCompletionEvent() const
+	{
+		return CompletionEvent;
+	}
+
+	const FFilterRequestCancellationPtr& GetCancellation() const
+	{
+		return Cancellation;
+	}
+
+	const FSourceImageRef& GetSourceImage() const
+	{
+		return SourceImage;
+	}
+
+	const FFilterPipelineParameters& GetParameters() const
+	{
+		return Parameters;
+	}
+
+	//Unset if the result cache is disabled. Set once GetCachedResult() is completed.
+	const TOptional<FFilterResultKey>& GetCacheKey() const
+	{
+		return CacheKey;
+	}
+
+	//Runs the work of a node on the calling thread, then releases the buffers nothing reads anymore. Called by the tasks of the backends.
+	void ExecuteNode(int32 InNodeIndex);
+
+private:
+	//Analyzes and logs the timings, ends the Insights region. Called by the finalize node.
+	void ReportProfile();
+
+	//Hashes the source and looks the result cache up, unless neither cache is enabled. Called by Create().
+	void LaunchCachedResultLookup();
+
+	//Looks every stage up in the stage cache, adds the missing ones and launches the wavefront(if any). Runs after the result cache lookup, before any stage node.
+	void LookUpStages();
+
+	//Looks the stage starting at InEntryNodeIndex up in the stage cache. Returns true if it was found, its output resource is set and its stage event waits for it then.
+	bool FindStage(int32 InEntryNodeIndex);
+
+	//Adds a launched stage to the stage cache(if the source was hashed) and to the request.
+	void AddStage(EPipelineStage InStage, int32 InOutputNodeIndex);
+
+	//Launches the vertical and horizontal pass at InNodeIndex as a wavefront(see LaunchWavefrontFilter()).
+	void LaunchWavefront(int32 InNodeIndex);
+
+	FPipelineStageKey MakeStageKey(EPipelineStage InStage) const;
+
+	FTaskImage GetResourceImage(int32 InResourceIndex) const;
+
+	//Leases the buffer of the resource InNodeIndex writes, unless an earlier resource sharing it did already.
+	void AcquireWrittenBuffer(int32 InNodeIndex);
+
+	//Counts the reads of InNodeIndex as done and releases the buffers whose reads are all done.
+	void ReleaseReads(int32 InNodeIndex);
+
+	const FCancellationTokenPtr& GetNodeToken(int32 InNodeIndex) const;
+
+	void LaunchNode(int32 InNodeIndex, EFilterPipelineBackend InBackend, const FFilterPipelinePipes* InPipes, bool InHoldRootTasks, TArray<FGraphEventRef, TInlineAllocator<FFilterPipelineGraph::MaxNodes>>& OutHeldEvents);
+
+	void Finalize();
+
+	const FFilterPipelineGraph& Graph;
+
+	FSourceImageRef SourceImage;
+
+	FFilterPipelineParameters Parameters;
+
+	//Unset if neither the result cache nor the stage cache is enabled, the wavefront then decodes the source without caching it. Set by the result cache lookup.
+	TOptional<uint64> SourceHash;
+
+	//Unset if the result cache is disabled. Set by the result cache lookup.
+	TOptional<FFilterResultKey> CacheKey;
+
+	UE::Tasks::TTask<FTransientTextureRef> CachedResult;
+
+	//Set by the result cache lookup. Every node but the finalize node skips its work then.
+	bool bResultCached = false;
+
+	UE::Tasks::FTask StageLookupTask;
+
+	FFilterRequestCancellationPtr Cancellation;
+
+	//Written by the composite node.
+	FTransientTextureTask CompositeTexture;
+
+	FTransientTextureTask ResultTexture;
+
+	UE::Tasks::FTask CompletionTask;
+
+	FGraphEventRef CompletionEvent;
+
+	//Per node state, indexed like the nodes of the graph.
+	UE::Tasks::FTask Tasks[FFilterPipelineGraph::MaxNodes];
+	FGraphEventRef Events[FFilterPipelineGraph::MaxNodes];
+	FFilterPipelineNodeTiming Timings[FFilterPipelineGraph::MaxNodes];
+
+	//The horizontal pass launched as a wavefront by the stage lookup, if any.
+	int32 WavefrontNode = INDEX_NONE;
+
+	//Set by Launch() if profiling is enabled. Names the Insights regions of the request.
+	FString ProfileName;
+
+	double LaunchTime = 0.0;
+
+	//Per buffer state, indexed by FFilterPipelineGraph::FResource::Slot.
+	TSharedPtr<FImage, ESPMode::ThreadSafe> Buffers[FFilterPipelineGraph::MaxResources];
+	std::atomic<int32> PendingSlotReads[FFilterPipelineGraph::MaxResources];
+
+	//Per stage state, indexed by EPipelineStage. The readers of a stage output wait for its event, which waits for the cached stage if it was found
+	//and for the output node of the stage otherwise. Triggered by the stage lookup.
+	TSharedPtr<FPipelineStageCancellation, ESPMode::ThreadSafe> StageCancellations[FFilterPipelineGraph::NumStages];
+	TOptional<UE::Tasks::FTaskEvent> StageEvents[FFilterPipelineGraph::NumStages];
+	bool bStageFound[FFilterPipelineGraph::NumStages] = {};
+};
+
+using FFilterPipelineRequestRef = TSharedRef<FFilterPipelineRequest, ESPMode::ThreadSafe>;
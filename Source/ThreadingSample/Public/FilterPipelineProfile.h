@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+
+class FFilterPipelineGraph;
+
+//When one node of a filter pipeline request ran and on which thread. Times are FPlatformTime::Seconds().
+struct FFilterPipelineNodeTiming
+{
+	double StartTime = 0.0;
+	double EndTime = 0.0;
+
+	//FPlatformTLS::GetCurrentThreadId(). 0 if the node went wide over several threads as a whole(a wavefront).
+	uint32 ThreadId = 0;
+
+	//Nodes reused from the stage cache or launched as part of another node are not recorded.
+	bool IsRecorded() const
+	{
+		return EndTime > 0.0;
+	}
+};
+
+//The analysis of one finished filter pipeline request(see AnalyzeFilterPipelineRun()). Times are in seconds.
+struct FFilterPipelineProfile
+{
+	//From launching the request until its finalize node is done.
+	double TotalTime = 0.0;
+
+	//The recorded nodes the finalize node waited for, transitively, picking the dependency that finished last at every step. First node first.
+	TArray<int32, TInlineAllocator<8>> CriticalPath;
+
+	//Time the nodes of the critical path ran, the rest of TotalTime they were waiting(for their thread, the result texture or a reused stage).
+	double CriticalPathRunTime = 0.0;
+
+	//From the moment a node could run(its dependencies are done) until it started, summed over the recorded nodes.
+	double QueueTime = 0.0;
+
+	//Time between the launch and the end of the last worker node during which no node of the request ran on a worker thread.
+	//The loops inside a node go wide through ParallelFor, so a busy node does not mean busy workers, but an idle request always means idle workers.
+	double WorkerIdleTime = 0.0;
+
+	//Worker threads that ran at least one node.
+	int32 NumWorkerThreads = 0;
+
+	//From the moment the finalize node could run until the game thread(the finalize queue) picked it up.
+	double GameThreadWaitTime = 0.0;
+};
+
+//ThreadingSample.Pipeline.Profile. Read by a request when it is launched.
+bool IsFilterPipelineProfilingEnabled();
+
+//Analyzes the timings of a request, indexed like the nodes of InGraph. InTimings of the finalize node has to be recorded.
+FFilterPipelineProfile AnalyzeFilterPipelineRun(const FFilterPipelineGraph& InGraph, double InLaunchTime, TConstArrayView<FFilterPipelineNodeTiming> InTimings);
+
+//Logs InProfile as one structured record, InName identifies the request(its Unreal Insights region).
+void LogFilterPipelineProfile(const FFilterPipelineGraph& InGraph, const FString& InName, bool InCanceled, const FFilterPipelineProfile& InProfile);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "TextureProcessing.h"
+#include "PipelineStageCache.h"
+
+//A downsampled approximation of a texture filter request that is delivered ahead of the full resolution result.
+struct FFilterPreview
+{
+	//Creates and holds the leased preview texture.
+	FTransientTextureTask Texture;
+
+	//Completed once the preview is uploaded, or skipped because the request was canceled or its full resolution result was finished first.
+	UE::Tasks::FTask UploadTask;
+
+	//Only written and read on the game thread.
+	TSharedRef<bool, ESPMode::ThreadSafe> bUploaded = MakeShared<bool, ESPMode::ThreadSafe>(false);
+
+	bool IsValid() const
+	{
+		return UploadTask.IsValid();
+	}
+
+	//Null until the preview is uploaded and if it was skipped.
+	UTexture2D* GetTexture()
+	{
+		if (IsValid() && UploadTask.IsCompleted() && *bUploaded)
+		{
+			return ExposeTransientTexture(Texture);
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+};
+
+//Whether InSourceTexture is large enough for a preview to be worth it(see ThreadingSample.Preview.Downsample).
+bool ShouldLaunchFilterPreview(UTexture2D* InSourceTexture);
+
+//Runs the pipeline on InSource(the snapshot of InSourceTexture) downsampled by ThreadingSample.Preview.Downsample,
+//with the filter size scaled down accordingly, as a single foreground priority task so it is picked before the background priority stages of the full request.
+//The preview shares the cancellation of the request. It skips its work and its upload if InFullResultTask is completed by then,
+//a preview is of no use once the full resolution result is there.
+FFilterPreview LaunchFilterPreview(UTexture2D* InSourceTexture, FSourceImageRef InSource, EFilterType InFilterType, int32 InFilterSize, float InScaleValue,
+	FFilterRequestCancellationPtr InCancellation, const UE::Tasks::FTask& InFullResultTask);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "Tasks/Task.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "WorkerBudget.h"
+
+#include "FilterQoS.generated.h"
+
+//How urgently the result of a texture filter request is needed.
+UENUM(BlueprintType)
+enum class EFilterQoS : uint8
+{
+	Interactive, //Someone is looking at it(previews, scrubbing a parameter). Runs on the foreground workers.
+	Normal,      //Runs on the background workers at high priority, like every request did before.
+	Batch        //Throughput work. Runs on the background workers at low priority and yields to interactive requests.
+};
+
+const TCHAR* EFilterQoSToString(EFilterQoS InQoS);
+
+//The QoS class, deadline and worker budget of one request, threaded through its stages like its cancellation token.
+struct FFilterQoS
+{
+	EFilterQoS Class = EFilterQoS::Normal;
+
+	//FPlatformTime::Seconds() by which the request should be finished, 0 if it has none.
+	double Deadline = 0.0;
+
+	//Shared by the loops of the request(see ParallelForWithBudget()). Null loops fan out over all workers.
+	FWorkerBudgetPtr WorkerBudget;
+
+	//A non positive InDeadlineSeconds means no deadline. The request gets its own worker budget(see FWorkerBudget::MakeRequestBudget()).
+	static FFilterQoS Make(EFilterQoS InClass, float InDeadlineSeconds);
+
+	bool IsPastDeadline() const
+	{
+		return Deadline > 0.0 && FPlatformTime::Seconds() > Deadline;
+	}
+
+	//Batch work that missed its deadline is promoted to BackgroundNormal so it is not postponed forever,
+	//it still runs below normal requests and never on the foreground workers.
+	LowLevelTasks::ETaskPriority GetTaskPriority() const;
+
+	//The task graph counterpart of GetTaskPriority().
+	ENamedThreads::Type GetDesiredThread() const;
+
+	//Batch loops go wide on the background workers only, ParallelFor would use the foreground workers otherwise.
+	EParallelForFlags GetParallelForFlags(bool InForceSingleThread) const;
+
+	//Called by batch work between batches of pixels and bands of rows. While interactive requests are in flight the calling(background) worker
+	//backs off for up to ThreadingSample.QoS.BatchYieldMs, leaving the cores to the foreground workers. Returns early once InCancellationToken is canceled.
+	void YieldToInteractiveWork(const UE::Tasks::FCancellationToken* InCancellationToken = nullptr) const;
+};
+
+//Counts a request as an interactive request in flight until InCompletionTask is completed.
+void TrackInteractiveRequest(const UE::Tasks::FTask& InCompletionTask);
+
+int32 GetNumInteractiveRequestsInFlight();
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TextureProcessing.h"
+
+//Everything the result of a texture filter pipeline depends on.
+struct FFilterResultKey
+{
+	//Hash of the size, format and pixels of the source mip.
+	uint64 SourceHash = 0;
+
+	EFilterType FilterType = EFilterType::BoxFilter;
+	int32 FilterSize = 0;
+	float ScaleValue = 0.0f;
+	EIntermediatePrecision IntermediatePrecision = EIntermediatePrecision::EightBit;
+
+	//A single 2D pass rounds differently than two 1D passes.
+	bool bOnePass = false;
+
+	bool operator==(const FFilterResultKey& Other) const
+	{
+		return SourceHash == Other.SourceHash && FilterType == Other.FilterType && FilterSize == Other.FilterSize && ScaleValue == Other.ScaleValue
+			&& IntermediatePrecision == Other.IntermediatePrecision && bOnePass == Other.bOnePass;
+	}
+};
+
+//InSourceHash is ComputeImageContentHash() of the source snapshot. The scale value is clamped like ScaleAlphaChannel() does.
+FFilterResultKey MakeFilterResultKey(uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InOnePass);
+
+//Keeps the uploaded results of recent filter requests, so a request with the same source pixels and parameters hands back the same texture
+//instead of running the pipeline again.
+//A cached result holds on to its lease, so the texture does not go back to the pool while it is cached. Cached textures must never be written.
+//Entries are evicted least recently used first whenever the cache exceeds ThreadingSample.ResultCache.MaxMemoryMB.
+class FFilterResultCache
+{
+public:
+	static FFilterResultCache& Get();
+
+	//Whether the pipelines should look up and add results. Controlled by ThreadingSample.ResultCache.Enable.
+	static bool IsEnabled();
+
+	//Returns the cached result or null. Can be called from any thread.
+	FTransientTextureRef Find(const FFilterResultKey& InKey);
+
+	//InResult has to be uploaded already. Can be called from any thread.
+	void Add(const FFilterResultKey& InKey, FTransientTextureRef InResult);
+
+	//Evicts entries until the cache fits in InMaxBytes.
+	void Trim(int64 InMaxBytes);
+
+	int64 GetCachedBytes() const;
+
+	int32 GetNumEntries() const;
+
+private:
+	FFilterResultCache() = default;
+
+	void TrimLocked(int64 InMaxBytes);
+
+	struct FEntry
+	{
+		FFilterResultKey Key;
+		FTransientTextureRef Result;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	//Ordered from the least recently used to the most recently used.
+	TArray<FEntry> Entries;
+
+	int64 CachedBytes = 0;
+};
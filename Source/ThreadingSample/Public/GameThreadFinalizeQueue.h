@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "Tickable.h"
+#include "Containers/Queue.h"
+#include "Tasks/Task.h"
+
+DECLARE_STATS_GROUP(TEXT("ThreadingSample"), STATGROUP_ThreadingSample, STATCAT_Advanced);
+
+//Runs the game thread work that finishes a request(uploading the result, broadcasting delegates) within a per frame budget.
+//Work is queued from any thread and drained oldest first while ThreadingSample.FinalizeQueue.BudgetMs lasts.
+//At least one item runs every frame, whatever is left is deferred to the next frame instead of hitching this one.
+class FGameThreadFinalizeQueue :public FTickableGameObject
+{
+public:
+	//The first call has to happen on the game thread, the pipelines call it while setting up.
+	static FGameThreadFinalizeQueue& Get();
+
+	//Can be called from any thread.
+	void Enqueue(TUniqueFunction<void()> InWork);
+
+	//Queues InWork once InPrerequisite is completed. The returned task is completed after InWork ran on the game thread.
+	UE::Tasks::FTask Launch(const TCHAR* InDebugName, TUniqueFunction<void()> InWork, const UE::Tasks::FTask& InPrerequisite);
+
+	//Items waiting to run.
+	int32 GetQueueDepth() const
+	{
+		return QueueDepth.load(std::memory_order_relaxed);
+	}
+
+	//Items left in the queue when the budget of the last frame ran out.
+	int32 GetNumDeferredLastFrame() const
+	{
+		return NumDeferredLastFrame;
+	}
+
+	//Total number of frames in which an item was deferred.
+	uint64 GetNumDeferredFrames() const
+	{
+		return NumDeferredFrames;
+	}
+
+	//Begin FTickableGameObject
+	virtual void Tick(float InDeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override
+	{
+		return ETickableTickType::Always;
+	}
+
+	virtual bool IsTickableWhenPaused() const override
+	{
+		return true;
+	}
+
+	virtual bool IsTickableInEditor() const override
+	{
+		return true;
+	}
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FGameThreadFinalizeQueue, STATGROUP_ThreadingSample);
+	}
+	//End FTickableGameObject
+
+private:
+	FGameThreadFinalizeQueue();
+
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Queue;
+
+	std::atomic<int32> QueueDepth{ 0 };
+
+	int32 NumDeferredLastFrame = 0;
+
+	uint64 NumDeferredFrames = 0;
+};
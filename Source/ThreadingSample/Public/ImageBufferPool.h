@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "ImageCore.h"
+
+//A CPU side image leased from FImageBufferPool. The image goes back to the pool when the last reference is released.
+//Unlike transient textures, image buffers can be leased and released on any thread and never need an UpdateResource().
+using FImageBufferRef = TSharedRef<FImage, ESPMode::ThreadSafe>;
+
+//Recycles the CPU side images that hold the intermediate results of the texture filter pipelines.
+//Idle images are freed oldest first whenever they exceed ThreadingSample.ImagePool.MaxIdleMemoryMB.
+class FImageBufferPool
+{
+public:
+	static FImageBufferPool& Get();
+
+	//Leases an idle image with the given size, format and gamma space or allocates a new one. Can be called from any thread.
+	//The pixels of a recycled image are left as they were, the caller is expected to overwrite all of them.
+	FImageBufferRef Acquire(int32 InSizeX, int32 InSizeY, ERawImageFormat::Type InFormat, EGammaSpace InGammaSpace);
+
+	//Frees idle images until they fit in InMaxBytes.
+	void Trim(int64 InMaxBytes);
+
+	int64 GetIdleBytes() const;
+
+	int32 GetNumIdleImages() const;
+
+private:
+	FImageBufferPool() = default;
+
+	void Return(FImage* InImage);
+
+	void TrimLocked(int64 InMaxBytes);
+
+	mutable FCriticalSection CriticalSection;
+
+	//Ordered from the least recently returned to the most recently returned.
+	TArray<TUniquePtr<FImage>> IdleImages;
+
+	int64 IdleBytes = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "ImageCore.h"
+#include "Tasks/Task.h"
+#include "SourceImageSnapshot.h"
+
+//A source texture decoded to linear RGBA32F, shared by every request that filters the same texture.
+struct FLinearSourceImage
+{
+	TSharedRef<const FImage, ESPMode::ThreadSafe> Image;
+
+	//Completed once Image holds the decoded pixels, Image must not be read before.
+	//Already completed if the texture was found in the cache.
+	UE::Tasks::FTask DecodeTask;
+
+	//Never write through RawData.
+	FImageView GetView() const
+	{
+		return FImageView(*Image, const_cast<uint8*>(Image->RawData.GetData()));
+	}
+};
+
+//Keeps linear RGBA32F copies of recently filtered source textures, so repeated requests on the same source skip the sRGB decode.
+//Entries are keyed by the content hash of the source(see LaunchImageContentHash()), its gamma space and its size, never by the texture object.
+//Any change of the pixels(a write, a reimport, a re-cache of the platform data) or of the sRGB flag gives a different key, so an entry can't go stale.
+//Entries are evicted least recently used first whenever the cache exceeds ThreadingSample.LinearImageCache.MaxMemoryMB, entries of old pixels simply age out.
+//Textures are not kept alive by the cache.
+class FLinearImageCache
+{
+public:
+	static FLinearImageCache& Get();
+
+	//Returns the cached linear copy of InSource, or launches a task decoding it from InSource. Can be called from any thread.
+	//InSourceHash is the content hash of InSource. Without it the source is decoded but not cached.
+	FLinearSourceImage Acquire(const FSourceImageRef& InSource, TOptional<uint64> InSourceHash);
+
+	//Evicts entries until the cache fits in InMaxBytes.
+	void Trim(int64 InMaxBytes);
+
+	int64 GetCachedBytes() const;
+
+	int32 GetNumEntries() const;
+
+private:
+	FLinearImageCache() = default;
+
+	void TrimLocked(int64 InMaxBytes);
+
+	struct FEntryKey
+	{
+		uint64 SourceHash = 0;
+		EGammaSpace GammaSpace = EGammaSpace::Linear;
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+
+		bool operator==(const FEntryKey& Other) const
+		{
+			return SourceHash == Other.SourceHash && GammaSpace == Other.GammaSpace && SizeX == Other.SizeX && SizeY == Other.SizeY;
+		}
+	};
+
+	struct FEntry
+	{
+		FEntryKey Key;
+		TSharedRef<const FImage, ESPMode::ThreadSafe> Image;
+		UE::Tasks::FTask DecodeTask;
+		int64 SizeInBytes = 0;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	//Ordered from the least recently used to the most recently used.
+	TArray<FEntry> Entries;
+
+	int64 CachedBytes = 0;
+};
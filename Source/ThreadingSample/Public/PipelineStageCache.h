@@ -0,0 +1,180 @@
+#pragma once
+
+#include "TextureProcessing.h"
+
+//The stages of the texture filter pipelines whose results can be reused by a later request.
+enum class EPipelineStage : uint8
+{
+	Blur,      //Both 1D passes or the 2D pass, depends on the filter parameters.
+	ScaleAlpha //Depends on the scale value only.
+};
+
+//Identifies the result of one stage by the source pixels and the parameters that stage depends on(and only those),
+//so changing the scale value does not invalidate the blur and vice versa.
+struct FPipelineStageKey
+{
+	EPipelineStage Stage = EPipelineStage::Blur;
+
+	//Hash of the size, format and pixels of the source mip.
+	uint64 SourceHash = 0;
+
+	//Blur parameters, left at their defaults for the scale alpha stage.
+	EFilterType FilterType = EFilterType::BoxFilter;
+	int32 FilterSize = 0;
+	EIntermediatePrecision IntermediatePrecision = EIntermediatePrecision::EightBit;
+	bool bOnePass = false;
+
+	//Scale alpha parameter, left at its default for the blur stage.
+	float ScaleValue = 0.0f;
+
+	bool operator==(const FPipelineStageKey& Other) const
+	{
+		return Stage == Other.Stage && SourceHash == Other.SourceHash && FilterType == Other.FilterType && FilterSize == Other.FilterSize
+			&& IntermediatePrecision == Other.IntermediatePrecision && bOnePass == Other.bOnePass && ScaleValue == Other.ScaleValue;
+	}
+};
+
+FPipelineStageKey MakeBlurStageKey(uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, EIntermediatePrecision InIntermediatePrecision, bool InOnePass);
+
+//The scale value is clamped like ScaleAlphaChannel() does.
+FPipelineStageKey MakeScaleAlphaStageKey(uint64 InSourceHash, float InScaleValue);
+
+//Cancels a stage once every request using it is canceled, so canceling a request never breaks another one that reuses its stages.
+class FPipelineStageCancellation
+{
+public:
+	UE_NONCOPYABLE(FPipelineStageCancellation);
+
+	FPipelineStageCancellation() = default;
+
+	//Adds a request using the stage. Fails if the stage is canceled already.
+	bool TryAddUser();
+
+	//Cancels the stage when the last request using it is released.
+	void ReleaseUser();
+
+	bool IsCanceled() const
+	{
+		return Token->IsCanceled();
+	}
+
+	//Checked by the tasks of the stage.
+	const FCancellationTokenPtr& GetToken() const
+	{
+		return Token;
+	}
+
+private:
+	FCancellationTokenPtr Token = MakeShared<UE::Tasks::FCancellationToken, ESPMode::ThreadSafe>();
+
+	//Starts with the request that launches the stage.
+	std::atomic<int32> NumUsers{ 1 };
+};
+
+using FPipelineStageCancellationRef = TSharedRef<FPipelineStageCancellation, ESPMode::ThreadSafe>;
+
+//The output of a stage.
+struct FPipelineStageResult
+{
+	FImageBufferRef Image;
+
+	//Completed once Image is fully written(or the stage is canceled). A result may be reused while its stage is still running.
+	UE::Tasks::FTask Task;
+
+	FPipelineStageCancellationRef Cancellation = MakeShared<FPipelineStageCancellation, ESPMode::ThreadSafe>();
+
+	//The QoS class of the request that launched the stage, its tasks run at that priority.
+	EFilterQoS QoS = EFilterQoS::Normal;
+};
+
+//The cancellation of one filter request. Canceling it skips the composite and the game thread update of the request,
+//and cancels the stages it launched or reused unless another request still uses them.
+class FFilterRequestCancellation
+{
+public:
+	//Registers a stage the request launched or found in the stage cache.
+	void AddStage(const FPipelineStageResult& InStage);
+
+	//Can be called more than once and from any thread.
+	void Cancel();
+
+	bool IsCanceled() const
+	{
+		return Token->IsCanceled();
+	}
+
+	//Checked by the composite task of the request.
+	const FCancellationTokenPtr& GetToken() const
+	{
+		return Token;
+	}
+
+private:
+	struct FStage
+	{
+		UE::Tasks::FTask Task;
+		FPipelineStageCancellationRef Cancellation;
+	};
+
+	FCriticalSection CriticalSection;
+
+	TArray<FStage> Stages;
+
+	FCancellationTokenPtr Token = MakeShared<UE::Tasks::FCancellationToken, ESPMode::ThreadSafe>();
+};
+
+using FFilterRequestCancellationPtr = TSharedPtr<FFilterRequestCancellation, ESPMode::ThreadSafe>;
+
+//Keeps the outputs of the latest pipeline stages, so a request that only changes some parameters reruns only the stages depending on them.
+//Scrubbing the scale value then costs a per pixel alpha pass and the composite instead of two convolutions.
+//Cached images are read only. Entries are evicted least recently used first whenever they exceed ThreadingSample.StageCache.MaxMemoryMB.
+class FPipelineStageCache
+{
+public:
+	static FPipelineStageCache& Get();
+
+	//Whether the pipelines should look up and add stage results. Controlled by ThreadingSample.StageCache.Enable.
+	static bool IsEnabled();
+
+	//Returns the result of an earlier stage with the same key, unset if there is none, it was canceled or ThreadingSample.StageCache.Enable is off.
+	//A stage that is still running at a lower QoS class than InQoS is not returned either, the caller launches its own.
+	//The caller becomes a user of the returned stage(see FPipelineStageCancellation). Can be called from any thread.
+	TOptional<FPipelineStageResult> Find(const FPipelineStageKey& InKey, EFilterQoS InQoS = EFilterQoS::Batch);
+
+	//Adds the result of a stage right after it was launched. Replaces an entry with the same key only if that one has a lower QoS class.
+	//Can be called from any thread.
+	void Add(const FPipelineStageKey& InKey, const FPipelineStageResult& InResult);
+
+	//Evicts entries until the cache fits in InMaxBytes.
+	void Trim(int64 InMaxBytes);
+
+	int64 GetCachedBytes() const;
+
+	int32 GetNumEntries() const;
+
+private:
+	FPipelineStageCache() = default;
+
+	void TrimLocked(int64 InMaxBytes);
+
+	struct FEntry
+	{
+		FPipelineStageKey Key;
+		FPipelineStageResult Result;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	//Ordered from the least recently used to the most recently used.
+	TArray<FEntry> Entries;
+
+	int64 CachedBytes = 0;
+};
+
+//Returns the cached blur(two 1D passes with an InIntermediatePrecision intermediate) of InSource,
+//or launches it as a wavefront at the priority of InQoS and adds it to the stage cache right away so later requests can reuse it while it is still running.
+//Either way the stage is registered with InRequest.
+FPipelineStageResult FindOrLaunchBlurStage(const FSourceImageRef& InSource, uint64 InSourceHash, EFilterType InFilterType, int32 InFilterSize, EIntermediatePrecision InIntermediatePrecision, const FFilterQoS& InQoS, FFilterRequestCancellation& InRequest);
+
+//Same as FindOrLaunchBlurStage() for the scale alpha stage.
+FPipelineStageResult FindOrLaunchScaleAlphaStage(const FSourceImageRef& InSource, uint64 InSourceHash, float InScaleValue, const FFilterQoS& InQoS, FFilterRequestCancellation& InRequest);
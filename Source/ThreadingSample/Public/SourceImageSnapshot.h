@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "ImageCore.h"
+#include "UObject/GCObject.h"
+
+class FSourceImageSnapshotRegistry;
+
+//A read-only view of mip 0 of a texture that any number of tasks can read at the same time without locking.
+//All snapshots of a texture share one Lock(LOCK_READ_ONLY) of its mip. The mip is unlocked once the last snapshot is released,
+//so concurrent readers neither copy the pixels nor trip the bulk data lock asserts.
+//The texture must not be written(or locked for writing) while a snapshot of it is alive.
+class FSourceImageSnapshot
+{
+public:
+	UE_NONCOPYABLE(FSourceImageSnapshot);
+
+	~FSourceImageSnapshot();
+
+	//Pixels are BGRA8, never write through RawData.
+	const FImageView& GetView() const
+	{
+		return View;
+	}
+
+	UTexture2D* GetTexture() const
+	{
+		return Texture;
+	}
+
+private:
+	friend class FSourceImageSnapshotRegistry;
+
+	FSourceImageSnapshot(UTexture2D* InTexture, const FImageView& InView)
+		:Texture(InTexture), View(InView)
+	{
+	}
+
+	UTexture2D* Texture = nullptr;
+
+	FImageView View;
+};
+
+using FSourceImageRef = TSharedRef<const FSourceImageSnapshot, ESPMode::ThreadSafe>;
+
+//Takes a snapshot of mip 0 of InSourceTexture. Can be called from any thread.
+//The texture is kept alive(referenced by the snapshot registry) while any snapshot of it exists.
+FSourceImageRef AcquireSourceImageSnapshot(UTexture2D* InSourceTexture);
+
+//Keeps track of the locked textures and how many snapshots read them.
+class FSourceImageSnapshotRegistry :public FGCObject
+{
+public:
+	static FSourceImageSnapshotRegistry& Get();
+
+	FSourceImageRef Acquire(UTexture2D* InTexture);
+
+	int32 GetNumLockedTextures() const;
+
+	//Begin FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FSourceImageSnapshotRegistry");
+	}
+	//End FGCObject
+
+private:
+	friend class FSourceImageSnapshot;
+
+	FSourceImageSnapshotRegistry() = default;
+
+	void Release(UTexture2D* InTexture);
+
+	struct FLockedTexture
+	{
+		TObjectPtr<UTexture2D> Texture;
+		FByteBulkData* BulkData = nullptr;
+		FImageView View;
+		int32 NumSnapshots = 0;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	TArray<FLockedTexture> LockedTextures;
+};
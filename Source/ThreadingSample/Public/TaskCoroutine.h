@@ -0,0 +1,206 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "Tasks/Task.h"
+#include "GameThreadFinalizeQueue.h"
+
+#include <coroutine>
+
+//The return type of a coroutine running on the task system. The coroutine starts right away on the calling thread and
+//GetTask() is completed once it returned(and its locals are destroyed), so other tasks and the finalize queue can take it as a prerequisite.
+//Nothing waits for it, the coroutine frame owns itself and is destroyed when the coroutine returns.
+class FTaskCoroutine
+{
+public:
+	struct promise_type
+	{
+		UE::Tasks::FTaskEvent CompletionEvent{ TEXT("TaskCoroutine") };
+
+		FTaskCoroutine get_return_object()
+		{
+			return FTaskCoroutine(CompletionEvent);
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		//Runs after the locals of the coroutine are destroyed, the frame goes away right after.
+		std::suspend_never final_suspend() noexcept
+		{
+			CompletionEvent.Trigger();
+			return {};
+		}
+
+		void return_void()
+		{
+		}
+
+		//Exceptions are disabled.
+		void unhandled_exception()
+		{
+			checkNoEntry();
+		}
+	};
+
+	const UE::Tasks::FTask& GetTask() const
+	{
+		return Task;
+	}
+
+private:
+	explicit FTaskCoroutine(const UE::Tasks::FTaskEvent& InCompletionEvent)
+		:Task(InCompletionEvent)
+	{
+	}
+
+	UE::Tasks::FTask Task;
+};
+
+//Resumes InHandle once InTask is completed, inline on the thread completing it. No thread blocks and no worker is woken up for the continuation,
+//the coroutine just carries on where the task finished.
+inline void ResumeAfterTask(const UE::Tasks::FTask& InTask, std::coroutine_handle<> InHandle)
+{
+	UE::Tasks::Launch(
+		TEXT("ResumeCoroutine"),
+		[InHandle]()
+		{
+			InHandle.resume();
+		},
+		UE::Tasks::Prerequisites(InTask),
+		LowLevelTasks::ETaskPriority::High,
+		UE::Tasks::EExtendedTaskPriority::Inline
+	);
+}
+
+//Awaits a task without a result(UE::Tasks::FTask is not a TTask<void>, it is the handle every task converts to). A completed task does not suspend the coroutine at all.
+struct FTaskAwaiter
+{
+	UE::Tasks::FTask Task;
+
+	bool await_ready() const
+	{
+		return Task.IsCompleted();
+	}
+
+	void await_suspend(std::coroutine_handle<> InHandle) const
+	{
+		//The coroutine may be resumed(and this awaiter destroyed with its frame) before Launch() returns, so the task is copied.
+		ResumeAfterTask(UE::Tasks::FTask(Task), InHandle);
+	}
+
+	void await_resume() const
+	{
+	}
+};
+
+//Awaits a task and evaluates to its result. A completed task does not suspend the coroutine at all.
+template<typename ResultType>
+struct TTaskAwaiter
+{
+	UE::Tasks::TTask<ResultType> Task;
+
+	bool await_ready() const
+	{
+		return Task.IsCompleted();
+	}
+
+	void await_suspend(std::coroutine_handle<> InHandle) const
+	{
+		//The coroutine may be resumed(and this awaiter destroyed with its frame) before Launch() returns, so the task is copied.
+		ResumeAfterTask(UE::Tasks::FTask(Task), InHandle);
+	}
+
+	//TTask::GetResult() is not const.
+	decltype(auto) await_resume()
+	{
+		if constexpr (std::is_void_v<ResultType>)
+		{
+			return;
+		}
+		else
+		{
+			return Task.GetResult();
+		}
+	}
+};
+
+//co_await on a task suspends until it is completed(see ResumeAfterTask()).
+inline FTaskAwaiter operator co_await(const UE::Tasks::FTask& InTask)
+{
+	return FTaskAwaiter{ InTask };
+}
+
+//co_await on a task with a result evaluates to its result.
+template<typename ResultType>
+TTaskAwaiter<ResultType> operator co_await(const UE::Tasks::TTask<ResultType>& InTask)
+{
+	return TTaskAwaiter<ResultType>{ InTask };
+}
+
+//Moves the awaiting coroutine to a task with InExtendedPriority, e.g. GameThreadNormalPri to continue on the game thread or None to continue on a worker.
+struct FResumeOnTaskAwaiter
+{
+	LowLevelTasks::ETaskPriority Priority = LowLevelTasks::ETaskPriority::Normal;
+
+	UE::Tasks::EExtendedTaskPriority ExtendedPriority = UE::Tasks::EExtendedTaskPriority::None;
+
+	bool await_ready() const
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> InHandle) const
+	{
+		UE::Tasks::Launch(
+			TEXT("ResumeCoroutine"),
+			[InHandle]()
+			{
+				InHandle.resume();
+			},
+			Priority,
+			ExtendedPriority
+		);
+	}
+
+	void await_resume() const
+	{
+	}
+};
+
+inline FResumeOnTaskAwaiter ResumeInBackground(LowLevelTasks::ETaskPriority InPriority)
+{
+	return FResumeOnTaskAwaiter{ InPriority, UE::Tasks::EExtendedTaskPriority::None };
+}
+
+inline FResumeOnTaskAwaiter ResumeOnGameThread(UE::Tasks::EExtendedTaskPriority InExtendedPriority = UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri)
+{
+	return FResumeOnTaskAwaiter{ LowLevelTasks::ETaskPriority::Normal, InExtendedPriority };
+}
+
+//Moves the awaiting coroutine to the game thread through the finalize queue, so it shares the per frame budget of the other uploads(see FGameThreadFinalizeQueue).
+struct FResumeOnFinalizeQueueAwaiter
+{
+	bool await_ready() const
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> InHandle) const
+	{
+		FGameThreadFinalizeQueue::Get().Enqueue([InHandle]()
+			{
+				InHandle.resume();
+			});
+	}
+
+	void await_resume() const
+	{
+	}
+};
+
+inline FResumeOnFinalizeQueueAwaiter ResumeOnFinalizeQueue()
+{
+	return FResumeOnFinalizeQueueAwaiter{};
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "ImageCore.h"
+#include "Tasks/Task.h"
+#include "SourceImageSnapshot.h"
+
+//Hashes of image contents for caching, change detection and deduplication, instead of comparing pixels by a full readback.
+//The pixels are split into fixed size chunks which are hashed(xxHash3) in parallel, the chunk hashes are then combined in order together with
+//the size, format and gamma space of the image. The result depends neither on the backend nor on the number of workers.
+
+//Hashes InImage on the calling thread and the ParallelFor workers, the caller is blocked until the hash is done.
+uint64 ComputeImageContentHash(const FImageView& InImage, bool InForceSingleThread = false);
+
+//Hashes the snapshot with one task per chunk and an inline task that combines them, the caller is not blocked.
+UE::Tasks::TTask<uint64> LaunchImageContentHash(FSourceImageRef InSource);
+
+//Hashes mip 0 of InTexture through a snapshot, so pipelines reading the texture at the same time are fine.
+uint64 ComputeTextureContentHash(UTexture2D* InTexture);
@@ -3,7 +3,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 
-#include "TextureProcessing.h"
+#include "FilterPipelineGraph.h"
 
 #include "TextureProcesser.generated.h"
 
@@ -26,20 +26,56 @@ class ATaskTextureFilter :public AActor
 	UPROPERTY(EditAnywhere, Meta = (ClampMin = 0.0f, ClampMax = 1.0f))
 	float ScaleValue = 1.0f;
 
+	UPROPERTY(EditAnywhere)
+	EIntermediatePrecision IntermediatePrecision = EIntermediatePrecision::EightBit;
+
+	UPROPERTY(EditAnywhere)
+	EFilterQoS QoS = EFilterQoS::Normal;
+
+	//Seconds from launching a request by which it should be finished, 0 for none(see FFilterQoS).
+	UPROPERTY(EditAnywhere, Meta = (ClampMin = 0.0f))
+	float DeadlineSeconds = 0.0f;
+
 protected:
-	UTexture2D* ProcessedResult = nullptr;
+	//Creates and holds the leased result of the running pipeline.
+	FTransientTextureTask ProcessedResult;
 
 	UPROPERTY(BlueprintAssignable)
 	FOnProcessFinished OnProcessFinished;
 
 public:
-	virtual void Tick(float InDeltaTime) override;
-
+	//Launches a pipeline filtering InSourceTexture, or queues the request if a pipeline is still running(replacing a queued one).
 	UFUNCTION(BlueprintCallable)
 	void StartProcessing(UTexture2D* InSourceTexture);
 
+	//Begin AActor
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//End AActor
+
 protected:
-	bool IsCompleted()const;
+	void LaunchRequest(UTexture2D* InSourceTexture);
+
+	//Launches the queued request, if any. A pipeline must not be in flight.
+	void LaunchPendingRequest();
+
+	//Called by the game thread finalize queue once the result of a request is uploaded. InRequestSerial is the payload of FOnFilterPipelineFinalized.
+	void FinishProcessing(FTransientTextureRef InResult, uint32 InRequestSerial);
+
+	//Cancels the request that is still running, if any. Its stages keep running if another request reuses them.
+	void CancelRunningRequest();
 
 	UE::Tasks::FTask Task;
+
+	//Cancellation of the running request.
+	FFilterRequestCancellationPtr Cancellation;
+
+	//Incremented by every launched request so a canceled one never gets broadcasted.
+	uint32 RequestSerial = 0;
+
+	//Set from launching a request until its result is broadcasted(or it is canceled).
+	bool bRequestInFlight = false;
+
+	//The latest request that came in while a pipeline was in flight.
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> PendingSourceTexture;
 };
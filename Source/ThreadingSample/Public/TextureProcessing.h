@@ -1,6 +1,14 @@
 #pragma once
 
 #include "ThreadingSample/ThreadingSample.h"
+#include "Tasks/Task.h"
+#include "Misc/MemStack.h"
+#include "TransientTexturePool.h"
+#include "ImageBufferPool.h"
+#include "SourceImageSnapshot.h"
+#include "TextureUpload.h"
+#include "GameThreadFinalizeQueue.h"
+#include "FilterQoS.h"
 
 #include "TextureProcessing.generated.h"
 
@@ -18,31 +26,187 @@ enum class EConvolutionType : uint8
 	OneDHorizontal
 };
 
+//Storage of the intermediate results between the filter passes.
+//Half and float intermediates are linear and skip the 8 bit round trip(quantization and sRGB encode/decode) between the passes,
+//at 2x and 4x the memory traffic of 8 bit.
+UENUM(BlueprintType)
+enum class EIntermediatePrecision : uint8
+{
+	EightBit, //BGRA8 in the color space of the source.
+	Half,     //Linear RGBA16F(FFloat16Color).
+	Float     //Linear RGBA32F(FLinearColor).
+};
+
 const TCHAR* EFilterTypeToString(EFilterType InFilterType);
 
+const TCHAR* EIntermediatePrecisionToString(EIntermediatePrecision InIntermediatePrecision);
+
 const TCHAR* EConvolutionTypeToString(EConvolutionType InConvolutionType);
 
-//A function that filters the RGB channels of InSourceTexture using ParallelFor.
+class FTaskImage;
+
+//Shared by the tasks of a request so the request can be canceled while they are queued or running.
+using FCancellationTokenPtr = TSharedPtr<UE::Tasks::FCancellationToken, ESPMode::ThreadSafe>;
+
+//Filter kernels are allocated from the FMemStack of the calling thread instead of the global allocator.
+//Compute them inside a FMemMark scope(e.g. at the beginning of a task body), everything is released when the mark goes out of scope.
+using FFilterWeights = TArray<float, TMemStackAllocator<>>;
+using FFilterOffsets = TArray<FIntPoint, TMemStackAllocator<>>;
+
+void ComputeFilterKernel(EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, FFilterWeights& OutWeights, FFilterOffsets& OutOffsets);
+
+//A function that filters the RGB channels of InSource using ParallelFor.
 //Can be done by one 2D convolution or two 1D convolutions.
 //[TextureWidth * TextureHeight * FilterSize * FilterSize] Or [2 * TextureWidth * TextureHeight * FilterSize]
-void FilterTexture(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutFilteredTexture, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread);
+//InSource and OutFiltered are BGRA8(decoded to and encoded from linear space per pixel) or linear RGBA16F/RGBA32F, in any combination.
+//These and the functions below check InCancellationToken once per batch of pixels and leave the rest of the output unwritten once it is canceled.
+//Batch InQoS work also yields to interactive requests once per batch(see FFilterQoS::YieldToInteractiveWork()).
+void FilterTexture(const FImageView& InSource, const FImageView& OutFiltered, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
+void FilterTexture(const FTaskImage& InSource, const FTaskImage& OutFiltered, EFilterType InFilterType, int32 InFilterSize, EConvolutionType InConvolutionType, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
 
-//A function that scales the alpha channel of InSourceTexture using ParallelFor.
-void ScaleAlphaChannel(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutScaledTexture, float InScaleValue, bool InForceSingleThread);
+//Filters the rows [InFirstRow, InFirstRow + InNumRows) of OutFiltered with a kernel from ComputeFilterKernel() on the calling thread.
+//Meant for schedulers that split a pass into tiles themselves.
+void FilterTextureRows(const FImageView& InSource, const FImageView& OutFiltered, TConstArrayView<float> InWeights, TConstArrayView<FIntPoint> InOffsets, int32 InFirstRow, int32 InNumRows);
 
-//A function that composites the RGB channels of a texture and the Alpha channel of another texture using ParallelFor.
-void CompositeRGBAValue(TWeakObjectPtr<UTexture2D> InRGBTexture, TWeakObjectPtr<UTexture2D> InATexture, TWeakObjectPtr<UTexture2D> OutTexture, bool InForceSingleThread);
+//A function that scales the alpha channel of InSource using ParallelFor.
+void ScaleAlphaChannel(const FImageView& InSource, const FImageView& OutScaled, float InScaleValue, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
+void ScaleAlphaChannel(const FTaskImage& InSource, const FTaskImage& OutScaled, float InScaleValue, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
+
+//A function that composites the RGB channels of an image and the Alpha channel of another image using ParallelFor.
+void CompositeRGBAValue(const FImageView& InRGB, const FImageView& InA, const FImageView& Out, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
+void CompositeRGBAValue(const FTaskImage& InRGB, const FTaskImage& InA, const FTaskImage& Out, bool InForceSingleThread, const UE::Tasks::FCancellationToken* InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
 
 bool ValidateParameters(UTexture2D* InSourceTexture, int InFilterSize, float InScaleValue);
 
-UTexture2D* CreateTransientTextureFromSource(UTexture2D* InSourceTexture, const FString& InTextureName, bool InCopySourceImage = false);
+//Leases a transient texture with the size, pixel format and settings of InSourceTexture from FTransientTexturePool.
+FTransientTextureRef CreateTransientTextureFromSource(UTexture2D* InSourceTexture, const FString& InTextureName);
+
+//Leases a transient texture that has the pixel format and settings of InSourceTexture but a different size.
+FTransientTextureRef CreateTransientTextureWithSize(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY, const FString& InTextureName);
+
+using FTransientTextureTask = UE::Tasks::TTask<FTransientTextureRef>;
+
+//The texture created by InTask, which has to be completed. Null if it could not be created(see CreateTransientTextureWithSizeAsync()).
+inline UTexture2D* GetTransientTexture(FTransientTextureTask& InTask)
+{
+	const FTransientTextureRef& Texture = InTask.GetResult();
+	return Texture.IsValid() ? Texture->GetTexture() : nullptr;
+}
+
+//Like GetTransientTexture() for a texture handed to Blueprint, which can hold on to it longer than the lease lives(see FTransientTextureLease::MarkExposed()).
+inline UTexture2D* ExposeTransientTexture(FTransientTextureTask& InTask)
+{
+	const FTransientTextureRef& Texture = InTask.GetResult();
+	if (Texture.IsValid())
+	{
+		Texture->MarkExposed();
+		return Texture->GetTexture();
+	}
+
+	return nullptr;
+}
+
+//Leases a transient texture like CreateTransientTextureFromSource() without blocking the caller.
+//Idle pooled textures are handed out right away, new ones are created by a game thread task.
+//Use the returned task as a prerequisite of the tasks that use the texture. Its result is null if InSourceTexture was garbage collected before the game thread task ran.
+FTransientTextureTask CreateTransientTextureFromSourceAsync(UTexture2D* InSourceTexture, const FString& InTextureName);
+
+//Leases a transient texture like CreateTransientTextureWithSize() without blocking the caller.
+FTransientTextureTask CreateTransientTextureWithSizeAsync(UTexture2D* InSourceTexture, int32 InSizeX, int32 InSizeY, const FString& InTextureName);
+
+//Leases a CPU side image with the size and color space of InSourceTexture from FImageBufferPool.
+//The pipelines keep their intermediate results in these, only the final result is written to a texture.
+FImageBufferRef AcquireImageBufferFromSource(UTexture2D* InSourceTexture);
+
+//Leases a CPU side image with the size of InSourceTexture for an intermediate result between filter passes.
+FImageBufferRef AcquireIntermediateImageBuffer(UTexture2D* InSourceTexture, EIntermediatePrecision InIntermediatePrecision);
+
+//Returns a graph event that is dispatched once InTask is completed, so that task graph tasks can depend on UE::Tasks tasks.
+FGraphEventRef MakeGraphEventFromTask(const UE::Tasks::FTask& InTask);
+
+//Returns a task that is completed once InGraphEvent is dispatched, so that UE::Tasks tasks can depend on task graph tasks.
+UE::Tasks::FTask MakeTaskFromGraphEvent(const FGraphEventRef& InGraphEvent);
+
+//An image read or written by a task. Either mip 0 of an existing texture, a transient texture that is created asynchronously,
+//a CPU image buffer or a read-only source snapshot.
+//Use FScopedTaskImageAccess to get at the pixels. A transient texture must only be accessed once its creation task is completed.
+class FTaskImage
+{
+public:
+	FTaskImage(UTexture2D* InTexture)
+		:Texture(InTexture)
+	{
+	}
+
+	FTaskImage(FTransientTextureTask InTransientTexture)
+		:TransientTexture(MoveTemp(InTransientTexture))
+	{
+	}
+
+	FTaskImage(FImageBufferRef InImageBuffer)
+		:ImageBuffer(MoveTemp(InImageBuffer))
+	{
+	}
+
+	FTaskImage(FSourceImageRef InSourceImage)
+		:SourceImage(MoveTemp(InSourceImage))
+	{
+	}
+
+	//Returns null for image buffers and source snapshots, and for textures that are gone.
+	UTexture2D* ResolveTexture() const;
+
+	//False if the image is a garbage collected texture or a transient texture that could not be created. The filter functions taking a FTaskImage skip their work then.
+	bool IsAvailable() const;
+
+	FImage* GetImageBuffer() const
+	{
+		return ImageBuffer.Get();
+	}
+
+	const FSourceImageSnapshot* GetSourceImage() const
+	{
+		return SourceImage.Get();
+	}
+
+private:
+	TWeakObjectPtr<UTexture2D> Texture;
+
+	//TTask::GetResult() is not const.
+	mutable FTransientTextureTask TransientTexture;
+
+	TSharedPtr<FImage, ESPMode::ThreadSafe> ImageBuffer;
+
+	TSharedPtr<const FSourceImageSnapshot, ESPMode::ThreadSafe> SourceImage;
+};
+
+//Exposes the pixels of a FTaskImage while in scope. Texture mips are locked with InLockFlags and unlocked on destruction.
+class FScopedTaskImageAccess
+{
+public:
+	UE_NONCOPYABLE(FScopedTaskImageAccess);
+
+	FScopedTaskImageAccess(const FTaskImage& InImage, uint32 InLockFlags);
+
+	~FScopedTaskImageAccess();
+
+	const FImageView& GetView() const
+	{
+		return View;
+	}
+
+private:
+	FByteBulkData* LockedBulkData = nullptr;
+
+	FImageView View;
+};
 
 //The task graph system tasks
 class FTextureFilterTask
 {
 public:
-	FTextureFilterTask(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> InFilteredTexture, EFilterType InFilterType, int InFilterSize, EConvolutionType InConvolutionType)
-		:FilterType(InFilterType), FilterSize(InFilterSize), ConvolutionType(InConvolutionType), SourceTexture(InSourceTexture), FilteredTexture(InFilteredTexture)
+	FTextureFilterTask(FTaskImage InSourceTexture, FTaskImage InFilteredTexture, EFilterType InFilterType, int InFilterSize, EConvolutionType InConvolutionType, FCancellationTokenPtr InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS())
+		:FilterType(InFilterType), FilterSize(InFilterSize), ConvolutionType(InConvolutionType), SourceTexture(InSourceTexture), FilteredTexture(InFilteredTexture), CancellationToken(MoveTemp(InCancellationToken)), QoS(InQoS)
 	{
 	}
 
@@ -51,9 +215,10 @@ public:
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FTextureFilterTask, STATGROUP_TaskGraphTasks);
 	}
 
-	static ENamedThreads::Type GetDesiredThread()
+	//Picked by the QoS class of the request.
+	ENamedThreads::Type GetDesiredThread() const
 	{
-		return ENamedThreads::AnyBackgroundHiPriTask;
+		return QoS.GetDesiredThread();
 	}
 
 	static ESubsequentsMode::Type GetSubsequentsMode()
@@ -63,7 +228,7 @@ public:
 
 	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
 	{
-		FilterTexture(SourceTexture, FilteredTexture, FilterType, FilterSize, ConvolutionType, false);
+		FilterTexture(SourceTexture, FilteredTexture, FilterType, FilterSize, ConvolutionType, false, CancellationToken.Get(), QoS);
 	}
 
 private:
@@ -71,16 +236,20 @@ private:
 	int FilterSize = 3;
 	EConvolutionType ConvolutionType = EConvolutionType::TwoD;
 
-	TWeakObjectPtr<UTexture2D> SourceTexture;
-	TWeakObjectPtr<UTexture2D> FilteredTexture;
+	FTaskImage SourceTexture;
+	FTaskImage FilteredTexture;
+
+	FCancellationTokenPtr CancellationToken;
+
+	FFilterQoS QoS;
 };
 
 //The task graph system tasks
 class FScaleAlphaChannelTask
 {
 public:
-	FScaleAlphaChannelTask(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> InScaledTexture, float InScaleValue)
-		: ScaleValue(InScaleValue), SourceTexture(InSourceTexture), ScaledTexture(InScaledTexture)
+	FScaleAlphaChannelTask(FTaskImage InSourceTexture, FTaskImage InScaledTexture, float InScaleValue, FCancellationTokenPtr InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS())
+		: ScaleValue(InScaleValue), SourceTexture(InSourceTexture), ScaledTexture(InScaledTexture), CancellationToken(MoveTemp(InCancellationToken)), QoS(InQoS)
 	{
 	}
 
@@ -89,9 +258,10 @@ public:
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FScaleAlphaChannelTask, STATGROUP_TaskGraphTasks);
 	}
 
-	static ENamedThreads::Type GetDesiredThread()
+	//Picked by the QoS class of the request.
+	ENamedThreads::Type GetDesiredThread() const
 	{
-		return ENamedThreads::AnyBackgroundHiPriTask;
+		return QoS.GetDesiredThread();
 	}
 
 	static ESubsequentsMode::Type GetSubsequentsMode()
@@ -101,22 +271,26 @@ public:
 
 	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
 	{
-		ScaleAlphaChannel(SourceTexture, ScaledTexture, ScaleValue, false);
+		ScaleAlphaChannel(SourceTexture, ScaledTexture, ScaleValue, false, CancellationToken.Get(), QoS);
 	}
 
 private:
 	float ScaleValue = 0.5;
 
-	TWeakObjectPtr<UTexture2D> SourceTexture;
-	TWeakObjectPtr<UTexture2D> ScaledTexture;
+	FTaskImage SourceTexture;
+	FTaskImage ScaledTexture;
+
+	FCancellationTokenPtr CancellationToken;
+
+	FFilterQoS QoS;
 };
 
 //The task graph system tasks
 class FCompositeRGBAValueTask
 {
 public:
-	FCompositeRGBAValueTask(TWeakObjectPtr<UTexture2D> InRGBTexture, TWeakObjectPtr<UTexture2D> InATexture, TWeakObjectPtr<UTexture2D> OutTexture)
-		: RGBTexture(InRGBTexture), AlphaTexture(InATexture), CompositedTexture(OutTexture)
+	FCompositeRGBAValueTask(FTaskImage InRGBTexture, FTaskImage InATexture, FTaskImage OutTexture, FCancellationTokenPtr InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS())
+		: RGBTexture(InRGBTexture), AlphaTexture(InATexture), CompositedTexture(OutTexture), CancellationToken(MoveTemp(InCancellationToken)), QoS(InQoS)
 	{
 	}
 
@@ -125,9 +299,10 @@ public:
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FCompositeRGBAValueTask, STATGROUP_TaskGraphTasks);
 	}
 
-	static ENamedThreads::Type GetDesiredThread()
+	//Picked by the QoS class of the request.
+	ENamedThreads::Type GetDesiredThread() const
 	{
-		return ENamedThreads::AnyBackgroundHiPriTask;
+		return QoS.GetDesiredThread();
 	}
 
 	static ESubsequentsMode::Type GetSubsequentsMode()
@@ -137,11 +312,15 @@ public:
 
 	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
 	{
-		CompositeRGBAValue(RGBTexture, AlphaTexture, CompositedTexture, false);
+		CompositeRGBAValue(RGBTexture, AlphaTexture, CompositedTexture, false, CancellationToken.Get(), QoS);
 	}
 
 private:
-	TWeakObjectPtr<UTexture2D> RGBTexture;
-	TWeakObjectPtr<UTexture2D> AlphaTexture;
-	TWeakObjectPtr<UTexture2D> CompositedTexture;
+	FTaskImage RGBTexture;
+	FTaskImage AlphaTexture;
+	FTaskImage CompositedTexture;
+
+	FCancellationTokenPtr CancellationToken;
+
+	FFilterQoS QoS;
 };
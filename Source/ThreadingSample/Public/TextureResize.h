@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "ImageCore.h"
+
+#include "TextureResize.generated.h"
+
+UENUM(BlueprintType)
+enum class EResizeFilter : uint8
+{
+	Mitchell, //Mitchell-Netravali cubic (B = C = 1/3), support of 2 pixels.
+	Lanczos3  //Windowed sinc, support of 3 pixels. Sharper but may ring around hard edges.
+};
+
+const TCHAR* EResizeFilterToString(EResizeFilter InResizeFilter);
+
+//Polyphase weight table of a 1D resampling pass.
+//Every destination pixel has the same number of taps so the inner loops have a fixed trip count.
+struct FResizeWeightTable
+{
+	int32 NumTaps = 0;
+
+	//The first source pixel that contributes to every destination pixel.
+	TArray<int32> FirstSourceIndex;
+
+	//NumTaps normalized weights for every destination pixel.
+	TArray<float> Weights;
+};
+
+void BuildResizeWeightTable(EResizeFilter InResizeFilter, int32 InSourceSize, int32 InTargetSize, FResizeWeightTable& OutTable);
+
+//Resizes the BGRA8 image InSource to the size of OutResized, both have to be in the same gamma space.
+//Done by a horizontal pass into a linear float intermediate followed by a vertical pass that writes straight into OutResized.
+//Both passes are split into bands of rows.
+//[TargetWidth * SourceHeight * HorizontalTaps + TargetWidth * TargetHeight * VerticalTaps]
+void ResizeImage(const FImageView& InSource, const FImageView& OutResized, EResizeFilter InResizeFilter, bool InForceSingleThread);
+
+//A function that resizes InSourceTexture to the size of OutResizedTexture using ParallelFor(see ResizeImage()).
+void ResizeTexture(TWeakObjectPtr<UTexture2D> InSourceTexture, TWeakObjectPtr<UTexture2D> OutResizedTexture, EResizeFilter InResizeFilter, bool InForceSingleThread);
+
+bool ValidateResizeParameters(UTexture2D* InSourceTexture, int32 InTargetWidth, int32 InTargetHeight);
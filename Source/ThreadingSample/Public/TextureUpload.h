@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "RHI.h"
+
+//Uploads the dirty regions of mip 0 of InTexture to its existing RHI texture with RHIUpdateTexture2D from a render command,
+//instead of recreating the whole resource like UpdateResource() does. An empty InDirtyRegions uploads the whole mip.
+//Falls back to UpdateResource() only when the texture has no resource yet(the first upload of a newly created texture) or its size changed.
+//The mip is read through a source snapshot until the render thread is done with it, so it must not be written in the meantime.
+//Must be called on the game thread. Works with NullRHI, where the upload is simply skipped.
+void UploadTextureRegions(UTexture2D* InTexture, TArray<FUpdateTextureRegion2D> InDirtyRegions = {});
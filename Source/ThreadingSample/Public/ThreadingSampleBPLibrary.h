@@ -7,7 +7,11 @@
 #include "AsyncLoadTextFile.h"
 #include "FRunnable.h"
 #include "FThread.h"
-#include "TextureProcessing.h"
+#include "WavefrontFilter.h"
+#include "FilterPipelineGraph.h"
+#include "BatchTextureFilter.h"
+#include "FilterPreview.h"
+#include "TextureResize.h"
 
 #include "ThreadingSampleBPLibrary.generated.h"
 
@@ -42,14 +46,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	bool IsReady() const
 	{
-		check(Result && TaskHandle.IsValid());
+		check(TaskHandle.IsValid());
 		return TaskHandle.IsCompleted();
 	}
 
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	UTexture2D* GetResult()
 	{
-		check(Result && TaskHandle.IsValid());
+		check(TaskHandle.IsValid());
 
 		//Explicitly wait the task to finish(We dont Wait here because calling Wait() will block the caller).
 		//
@@ -60,9 +64,9 @@ public:
 		// FTimespan WaitTime = FTimespan::FromMilliseconds(2);
 		// TaskHandle.Wait(WaitTime);
 
-		if (TaskHandle.IsCompleted())
+		if (Result.IsValid() && TaskHandle.IsCompleted())
 		{
-			return Result;
+			return ExposeTransientTexture(Result);
 		}
 		else
 		{
@@ -70,19 +74,79 @@ public:
 		}
 	}
 
-	void SetResult(UTexture2D* InTexture, UE::Tasks::FTask InTaskHandle)
+	//Abandons the request. Its remaining work and its upload are skipped and GetResult() returns null from now on.
+	//Does nothing once the request is finished, its result may be shown already.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	void Cancel()
+	{
+		if (TaskHandle.IsValid() && TaskHandle.IsCompleted())
+		{
+			return;
+		}
+
+		if (Cancellation.IsValid())
+		{
+			Cancellation->Cancel();
+		}
+
+		//The leased texture goes back to the pool once the tasks of the request are done with it.
+		Result = FTransientTextureTask{};
+		Preview = FFilterPreview{};
+	}
+
+	//Completed once the result is uploaded(or skipped after Cancel()). Game thread continuations can take it as a prerequisite instead of polling IsReady().
+	const UE::Tasks::FTask& GetCompletionTask() const
+	{
+		return TaskHandle;
+	}
+
+	//Whether the preview is uploaded or skipped. False if no preview was requested.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	bool IsPreviewReady() const
+	{
+		return Preview.IsValid() && Preview.UploadTask.IsCompleted();
+	}
+
+	//The downsampled preview. Null if none was requested, until it is uploaded, and if it was skipped because the full result was finished first.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	UTexture2D* GetPreview()
+	{
+		return Preview.GetTexture();
+	}
+
+	//Invalid if no preview was requested.
+	const UE::Tasks::FTask& GetPreviewCompletionTask() const
+	{
+		return Preview.UploadTask;
+	}
+
+	void SetPreview(FFilterPreview InPreview)
 	{
-		check(InTexture && InTaskHandle.IsValid());
-		check(!Result && !TaskHandle.IsValid());
+		check(InPreview.IsValid() && !Preview.IsValid());
+
+		Preview = MoveTemp(InPreview);
+	}
+
+	void SetResult(FTransientTextureTask InTexture, UE::Tasks::FTask InTaskHandle, FFilterRequestCancellationPtr InCancellation = nullptr)
+	{
+		check(InTexture.IsValid() && InTaskHandle.IsValid());
+		check(!Result.IsValid() && !TaskHandle.IsValid());
 
 		Result = InTexture;
 		TaskHandle = InTaskHandle;
+		Cancellation = MoveTemp(InCancellation);
 	}
 
 private:
-	UTexture2D* Result;
+	//Creates and holds the leased result texture. It goes back to the pool when this object is garbage collected(or canceled), unless GetResult() handed it out.
+	FTransientTextureTask Result;
 
 	UE::Tasks::FTask TaskHandle;
+
+	FFilterRequestCancellationPtr Cancellation;
+
+	//Delivered ahead of the result if requested.
+	FFilterPreview Preview;
 };
 
 //Wrap the result returned using task graph system
@@ -95,21 +159,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	bool IsReady() const
 	{
-		check(Result && TaskEvent.IsValid());
+		check(TaskEvent.IsValid());
 		return TaskEvent->IsCompleted();
 	}
 
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	UTexture2D* GetResult()
 	{
-		check(Result && TaskEvent.IsValid());
+		check(TaskEvent.IsValid());
 
 		//Explicitly wait the task to finish(We dont Wait here because calling Wait() will block the caller).
 		// TaskEvent->Wait();
 
-		if (TaskEvent->IsCompleted())
+		if (Result.IsValid() && TaskEvent->IsCompleted())
 		{
-			return Result;
+			return ExposeTransientTexture(Result);
 		}
 		else
 		{
@@ -117,19 +181,78 @@ public:
 		}
 	}
 
-	void SetResult(UTexture2D* InTexture, FGraphEventRef InTaskEvent)
+	//Abandons the request. Its remaining work and its upload are skipped and GetResult() returns null from now on.
+	//Does nothing once the request is finished, its result may be shown already.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	void Cancel()
 	{
-		check(InTexture && InTaskEvent.IsValid());
-		check(!Result && !TaskEvent.IsValid());
+		if (TaskEvent.IsValid() && TaskEvent->IsCompleted())
+		{
+			return;
+		}
+
+		if (Cancellation.IsValid())
+		{
+			Cancellation->Cancel();
+		}
+
+		Result = FTransientTextureTask{};
+		Preview = FFilterPreview{};
+	}
+
+	//Dispatched once the result is uploaded(or skipped after Cancel()).
+	const FGraphEventRef& GetCompletionEvent() const
+	{
+		return TaskEvent;
+	}
+
+	//Whether the preview is uploaded or skipped. False if no preview was requested.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	bool IsPreviewReady() const
+	{
+		return Preview.IsValid() && Preview.UploadTask.IsCompleted();
+	}
+
+	//The downsampled preview. Null if none was requested, until it is uploaded, and if it was skipped because the full result was finished first.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	UTexture2D* GetPreview()
+	{
+		return Preview.GetTexture();
+	}
+
+	//Invalid if no preview was requested.
+	const UE::Tasks::FTask& GetPreviewCompletionTask() const
+	{
+		return Preview.UploadTask;
+	}
+
+	void SetPreview(FFilterPreview InPreview)
+	{
+		check(InPreview.IsValid() && !Preview.IsValid());
+
+		Preview = MoveTemp(InPreview);
+	}
+
+	void SetResult(FTransientTextureTask InTexture, FGraphEventRef InTaskEvent, FFilterRequestCancellationPtr InCancellation = nullptr)
+	{
+		check(InTexture.IsValid() && InTaskEvent.IsValid());
+		check(!Result.IsValid() && !TaskEvent.IsValid());
 
 		Result = InTexture;
 		TaskEvent = InTaskEvent;
+		Cancellation = MoveTemp(InCancellation);
 	}
 
 private:
-	UTexture2D* Result;
+	//Creates and holds the leased result texture. It goes back to the pool when this object is garbage collected(or canceled), unless GetResult() handed it out.
+	FTransientTextureTask Result;
 
 	FGraphEventRef TaskEvent;
+
+	FFilterRequestCancellationPtr Cancellation;
+
+	//Delivered ahead of the result if requested.
+	FFilterPreview Preview;
 };
 
 //Wrap the result returned using pipe
@@ -142,24 +265,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	bool IsReady() const
 	{
-		check(Result && Pipe.IsValid());
-		return !Pipe->HasWork();
+		return !HasPipedWork(Pipes) && UploadTask.IsCompleted();
 	}
 
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	UTexture2D* GetResult()
 	{
-		check(Result && Pipe.IsValid());
-
 		//Explicitly wait the to be empty(We dont Wait here because calling Wait() will block the caller).
 		// Pipe->WaitUntilEmpty();
 		//Wait with a timeout
 		// FTimespan WaitTime = FTimespan::FromMilliseconds(2);
 		// Pipe->WaitUntilEmpty(WaitTime);
 
-		if (!Pipe->HasWork())
+		if (Result.IsValid() && !HasPipedWork(Pipes) && UploadTask.IsCompleted())
 		{
-			return Result;
+			return ExposeTransientTexture(Result);
 		}
 		else
 		{
@@ -167,25 +287,180 @@ public:
 		}
 	}
 
-	void SetResult(UTexture2D* InTexture, TUniquePtr<UE::Tasks::FPipe> InPipe)
+	//Abandons the request. Its piped tasks still run one after another(per pipe) but skip their work, the upload is skipped too.
+	//GetResult() returns null from now on. Does nothing once the request is finished, its result may be shown already.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	void Cancel()
+	{
+		if (UploadTask.IsValid() && IsReady())
+		{
+			return;
+		}
+
+		if (Cancellation.IsValid())
+		{
+			Cancellation->Cancel();
+		}
+
+		Result = FTransientTextureTask{};
+		Preview = FFilterPreview{};
+	}
+
+	//Completed once the result is uploaded(or skipped after Cancel()). The upload follows the last piped task, the pipes are empty by then.
+	const UE::Tasks::FTask& GetCompletionTask() const
 	{
-		check(InTexture && InPipe.IsValid());
-		check(!Result && !Pipe.IsValid());
+		return UploadTask;
+	}
+
+	//Whether the preview is uploaded or skipped. False if no preview was requested.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	bool IsPreviewReady() const
+	{
+		return Preview.IsValid() && Preview.UploadTask.IsCompleted();
+	}
+
+	//The downsampled preview. Null if none was requested, until it is uploaded, and if it was skipped because the full result was finished first.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	UTexture2D* GetPreview()
+	{
+		return Preview.GetTexture();
+	}
+
+	//Invalid if no preview was requested.
+	const UE::Tasks::FTask& GetPreviewCompletionTask() const
+	{
+		return Preview.UploadTask;
+	}
+
+	void SetPreview(FFilterPreview InPreview)
+	{
+		check(InPreview.IsValid() && !Preview.IsValid());
+
+		Preview = MoveTemp(InPreview);
+	}
+
+	void SetResult(FTransientTextureTask InTexture, FFilterPipelinePipes InPipes, UE::Tasks::FTask InUploadTask, FFilterRequestCancellationPtr InCancellation = nullptr)
+	{
+		check(InTexture.IsValid() && InPipes.Num() > 0 && InUploadTask.IsValid());
+		check(!Result.IsValid() && Pipes.Num() == 0);
 
 		Result = InTexture;
-		Pipe = MoveTemp(InPipe);
+		Pipes = MoveTemp(InPipes);
+		UploadTask = InUploadTask;
+		Cancellation = MoveTemp(InCancellation);
+	}
+
+private:
+	//Creates and holds the leased result texture. It goes back to the pool when this object is garbage collected(or canceled), unless GetResult() handed it out.
+	FTransientTextureTask Result;
+
+	//One per lane of the pipeline graph(see MakeFilterPipelinePipes()).
+	FFilterPipelinePipes Pipes;
+
+	//The upload runs on the game thread finalize queue after the last piped task.
+	UE::Tasks::FTask UploadTask;
+
+	FFilterRequestCancellationPtr Cancellation;
+
+	//Delivered ahead of the result if requested.
+	FFilterPreview Preview;
+};
+
+//Wrap the results of a batch of textures filtered through a concurrency limiter
+UCLASS(BlueprintType)
+class UBatchFilterResult :public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	bool IsReady() const
+	{
+		check(Batch.IsValid());
+		return Batch->GetCompletionTask().IsCompleted();
+	}
+
+	//Indexed like the source textures, null for a texture whose source was garbage collected. Empty until the whole batch is uploaded, and after Cancel().
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	TArray<UTexture2D*> GetResults()
+	{
+		TArray<UTexture2D*> Results;
+
+		if (Batch.IsValid() && !Batch->IsCanceled() && Batch->GetCompletionTask().IsCompleted())
+		{
+			//TTask::GetResult() is not const.
+			for (FTransientTextureTask Result : Batch->GetResults())
+			{
+				Results.Add(ExposeTransientTexture(Result));
+			}
+		}
+
+		return Results;
+	}
+
+	//Textures uploaded(or skipped) so far.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	int32 GetNumFinished() const
+	{
+		return Batch.IsValid() ? Batch->GetNumFinished() : 0;
 	}
 
-	UResultUsingPipe()
+	//Abandons the batch. Textures that did not start yet are skipped and nothing is uploaded anymore.
+	//Does nothing once the whole batch is uploaded.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	void Cancel()
 	{
-		Result = nullptr;
-		Pipe = nullptr;
+		if (Batch.IsValid() && !Batch->GetCompletionTask().IsCompleted())
+		{
+			Batch->Cancel();
+		}
+	}
+
+	bool IsCanceled() const
+	{
+		return Batch.IsValid() && Batch->IsCanceled();
+	}
+
+	//Completed once every texture is uploaded(or skipped after Cancel()). Game thread continuations can take it as a prerequisite instead of polling IsReady().
+	UE::Tasks::FTask GetCompletionTask() const
+	{
+		return Batch.IsValid() ? Batch->GetCompletionTask() : UE::Tasks::FTask(UE::Tasks::MakeCompletedTask<void>());
+	}
+
+	//InSourceTextures are the sources the batch was launched with.
+	void SetBatch(FBatchTextureFilterRef InBatch, TConstArrayView<UTexture2D*> InSourceTextures)
+	{
+		check(!Batch.IsValid());
+
+		Batch = MoveTemp(InBatch);
+
+		for (UTexture2D* SourceTexture : InSourceTextures)
+		{
+			SourceTextures.Add(SourceTexture);
+		}
+
+		//Released on the game thread once the batch is done reading them.
+		FGameThreadFinalizeQueue::Get().Launch(
+			UE_SOURCE_LOCATION,
+			[WeakThis = TWeakObjectPtr<UBatchFilterResult>(this)]()
+			{
+				if (UBatchFilterResult* This = WeakThis.Get())
+				{
+					This->SourceTextures.Empty();
+				}
+			},
+			Batch->GetCompletionTask()
+		);
 	}
 
 private:
-	UTexture2D* Result;
+	//Holds the leased result textures. They go back to the pool when this object is garbage collected.
+	TSharedPtr<FBatchTextureFilter, ESPMode::ThreadSafe> Batch;
 
-	TUniquePtr<UE::Tasks::FPipe> Pipe;
+	//The batch only holds weak pointers to its sources. They are referenced here until the batch completed, so none is garbage collected before its
+	//result texture is created and its snapshot is taken.
+	UPROPERTY()
+	TArray<TObjectPtr<UTexture2D>> SourceTextures;
 };
 
 UCLASS()
@@ -197,16 +472,61 @@ class THREADINGSAMPLE_API UThreadingSampleBPLibrary : public UBlueprintFunctionL
 	static void LoadTextFiles(ELoadTextFileExecution InExecution, float InSleepTimeInSeconds, const TArray<FString>& InFilesToLoad, TArray<UTextFileResult*>& OutResults);
 
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
-	static void FilterTextureUsingParallelFor(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InOnePass, bool InForceSingleThread, UTexture2D*& OutFilteredTexture);
+	static void ResizeTexture(UTexture2D* InSourceTexture, int32 InTargetWidth, int32 InTargetHeight, EResizeFilter InResizeFilter, bool InForceSingleThread, UTexture2D*& OutResizedTexture);
+
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void FilterTextureUsingParallelFor(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InOnePass, bool InForceSingleThread, EIntermediatePrecision InIntermediatePrecision, UTexture2D*& OutFilteredTexture);
+
+	//With InProgressivePreview a downsampled approximation is delivered first through GetPreview() of the result(see LaunchFilterPreview()).
+	//InQoS picks the priority of the tasks, batch requests yield to interactive ones. A positive InDeadlineSeconds promotes a batch request that misses it.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void FilterTextureUsingTaskSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskSystem*& OutResult);
+
+	//Runs the wavefront filter InNumIterations times with every intermediate precision and logs the time, the intermediate memory traffic
+	//and the error against the float intermediate. Blocks the game thread until all runs are done.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void BenchmarkIntermediatePrecision(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumIterations);
+
+	//Hashes mip 0 of InSourceTexture InNumIterations times on a single thread, with ParallelFor and with the task system, and logs the throughput.
+	//Blocks the game thread until all runs are done.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void BenchmarkContentHash(UTexture2D* InSourceTexture, int32 InNumIterations);
+
+	//Runs InNumConcurrentRequests filter requests(vertical pass and alpha scale concurrently, then horizontal pass and composite) at the same time,
+	//InNumIterations times with plain ParallelFor loops and with loops limited by the worker budget of each request, and logs the time of both.
+	//Blocks the game thread until all runs are done.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void BenchmarkWorkerBudget(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumConcurrentRequests, int32 InNumIterations);
+
+	//With InProgressivePreview a downsampled approximation is delivered first through GetPreview() of the result(see LaunchFilterPreview()).
+	//InQoS picks the priority of the tasks, batch requests yield to interactive ones. A positive InDeadlineSeconds promotes a batch request that misses it.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void FilterTextureUsingTaskGraphSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InHoldSourceTasks, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskGraphSystem*& OutResult);
+
+	//Every lane of the pipeline graph gets its own pipe, so the blur and the alpha scale overlap while the passes of each still run one after another.
+	//With InProgressivePreview a downsampled approximation is delivered first through GetPreview() of the result(see LaunchFilterPreview()).
+	//InQoS picks the priority of the tasks, batch requests yield to interactive ones. A positive InDeadlineSeconds promotes a batch request that misses it.
+	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
+	static void FilterTextureUsingPipe(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingPipe*& OutResult);
 
+	//The same pipeline written as one coroutine(see FilterTextureCoroutine()). The passes run one after another on the worker the coroutine resumed on,
+	//only the alpha scale is a task of its own, so setting up a request launches two tasks instead of one per node. Stages are not shared through the stage cache.
+	//With InProgressivePreview a downsampled approximation is delivered first through GetPreview() of the result(see LaunchFilterPreview()).
+	//InQoS picks the priority of the tasks, batch requests yield to interactive ones. A positive InDeadlineSeconds promotes a batch request that misses it.
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
-	static void FilterTextureUsingTaskSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, UResultUsingTaskSystem*& OutResult);
+	static void FilterTextureUsingCoroutine(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, bool InProgressivePreview, EFilterQoS InQoS, float InDeadlineSeconds, UResultUsingTaskSystem*& OutResult);
 
+	//Runs InNumIterations requests one after another through the node tasks of FilterTextureUsingTaskSystem() and through the coroutine of FilterTextureUsingCoroutine(),
+	//from setup to upload with the caches bypassed, and logs the time per request of both. Meant for small textures, where the scheduling overhead is not hidden by the passes.
+	//Blocks the game thread until all runs are done, the finalize queue and the game thread tasks are pumped meanwhile.
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
-	static void FilterTextureUsingTaskGraphSystem(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, bool InHoldSourceTasks, UResultUsingTaskGraphSystem*& OutResult);
+	static void BenchmarkCoroutine(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, int32 InNumIterations);
 
+	//Filters every texture of InSourceTextures through a concurrency limiter at batch QoS(see FBatchTextureFilter). At most InMaxConcurrency textures(0 for one per worker)
+	//are processed at the same time, each on one worker with the scratch images of its concurrency slot. Peak memory is one result texture per source texture(all leased up front)
+	//plus InMaxConcurrency working sets of scratch images and source snapshots, the working sets do not grow with the number of textures.
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
-	static void FilterTextureUsingPipe(UTexture2D* InSourceTexture, EFilterType InFilterType, int InFilterSize, float InScaleValue, UResultUsingPipe*& OutResult);
+	static void FilterTexturesInBatch(const TArray<UTexture2D*>& InSourceTextures, EFilterType InFilterType, int InFilterSize, float InScaleValue, EIntermediatePrecision InIntermediatePrecision, int32 InMaxConcurrency, UBatchFilterResult*& OutResult);
 
 	UFUNCTION(BlueprintCallable, Category = "Threading Sample")
 	static void ExecuteNestedTask(int InCurrentCallIndex);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "UObject/GCObject.h"
+
+//Textures are only interchangeable if all of these match.
+struct FTransientTextureKey
+{
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	EPixelFormat PixelFormat = PF_Unknown;
+	bool bSRGB = false;
+
+	FTransientTextureKey() = default;
+
+	FTransientTextureKey(int32 InSizeX, int32 InSizeY, EPixelFormat InPixelFormat, bool InSRGB)
+		:SizeX(InSizeX), SizeY(InSizeY), PixelFormat(InPixelFormat), bSRGB(InSRGB)
+	{
+	}
+
+	int64 GetSizeInBytes() const;
+
+	bool operator==(const FTransientTextureKey& Other) const
+	{
+		return SizeX == Other.SizeX && SizeY == Other.SizeY && PixelFormat == Other.PixelFormat && bSRGB == Other.bSRGB;
+	}
+
+	friend uint32 GetTypeHash(const FTransientTextureKey& InKey)
+	{
+		uint32 Hash = HashCombineFast(::GetTypeHash(InKey.SizeX), ::GetTypeHash(InKey.SizeY));
+		Hash = HashCombineFast(Hash, ::GetTypeHash(int32(InKey.PixelFormat)));
+		return HashCombineFast(Hash, ::GetTypeHash(InKey.bSRGB));
+	}
+};
+
+//A transient texture leased from FTransientTexturePool.
+//The texture goes back to the pool when the last reference to the lease is released, so whoever shows or reads the texture
+//has to hold a reference(the tasks that write the texture do). Textures handed to Blueprint are marked with MarkExposed() instead.
+class FTransientTextureLease
+{
+public:
+	~FTransientTextureLease();
+
+	UTexture2D* GetTexture() const
+	{
+		return Texture;
+	}
+
+	const FTransientTextureKey& GetKey() const
+	{
+		return Key;
+	}
+
+	//Takes the texture out of the pool for good. It is then a plain transient object which will be collected by GC once nothing references it.
+	UTexture2D* Detach();
+
+	//For textures handed to code that may keep them after the lease is released(Blueprint, delegates). Can be called from any thread.
+	//The texture is never recycled then, the last lease reference detaches it instead of returning it to the pool.
+	void MarkExposed()
+	{
+		bExposed.store(true, std::memory_order_relaxed);
+	}
+
+private:
+	friend class FTransientTexturePool;
+
+	FTransientTextureLease(UTexture2D* InTexture, const FTransientTextureKey& InKey)
+		:Texture(InTexture), Key(InKey)
+	{
+	}
+
+	UTexture2D* Texture = nullptr;
+	FTransientTextureKey Key;
+	std::atomic<bool> bExposed{ false };
+};
+
+using FTransientTextureRef = TSharedPtr<FTransientTextureLease, ESPMode::ThreadSafe>;
+
+//Recycles the transient textures used by the texture filter samples instead of creating new ones and adding them to root for every request.
+//Pooled textures are kept alive by the pool itself(as a FGCObject), leased or not.
+//Idle textures are evicted oldest first whenever the pool exceeds ThreadingSample.TexturePool.MaxMemoryMB.
+class FTransientTexturePool :public FGCObject
+{
+public:
+	static FTransientTexturePool& Get();
+
+	//Leases an idle texture matching InKey or creates a new one.
+	//Creating a texture has to happen on the game thread, use TryAcquireIdle() to lease from other threads.
+	FTransientTextureRef Acquire(const FTransientTextureKey& InKey, const FString& InDebugName);
+
+	//Leases an idle texture matching InKey if there is one. Can be called from any thread.
+	FTransientTextureRef TryAcquireIdle(const FTransientTextureKey& InKey);
+
+	//Evicts idle textures until the pool fits in InMaxBytes.
+	void Trim(int64 InMaxBytes);
+
+	int64 GetPooledBytes() const;
+
+	int32 GetNumIdleTextures() const;
+
+	int32 GetNumLeasedTextures() const;
+
+	//Begin FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FTransientTexturePool");
+	}
+	//End FGCObject
+
+private:
+	friend class FTransientTextureLease;
+
+	FTransientTexturePool() = default;
+
+	void Return(UTexture2D* InTexture, const FTransientTextureKey& InKey);
+
+	void Forget(UTexture2D* InTexture, const FTransientTextureKey& InKey);
+
+	void TrimLocked(int64 InMaxBytes);
+
+	struct FIdleTexture
+	{
+		FTransientTextureKey Key;
+		TObjectPtr<UTexture2D> Texture;
+		//The value of GFrameCounter when the texture was returned.
+		uint64 ReturnFrame = 0;
+	};
+
+	mutable FCriticalSection CriticalSection;
+
+	//Ordered from the least recently returned to the most recently returned.
+	TArray<FIdleTexture> IdleTextures;
+
+	TArray<TObjectPtr<UTexture2D>> LeasedTextures;
+
+	//Bytes of the idle and leased textures.
+	int64 PooledBytes = 0;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "TextureProcessing.h"
+
+//Runs the 1D vertical pass and the 1D horizontal pass of a separable filter as a wavefront of row band tasks instead of two ParallelFor passes.
+//Every horizontal band depends only on the vertical bands covering its rows(plus the apron of the horizontal kernel),
+//so it starts as soon as those are done instead of waiting for the whole vertical pass. The task scheduler balances the bands over the workers(work stealing).
+//InVerticalPassResult is read by many bands at once, hence an image buffer rather than a texture. Its format is the precision of the intermediate
+//between the passes(see AcquireIntermediateImageBuffer()).
+//The vertical bands read the linear copy of InSource from FLinearImageCache, so a source filtered before is not decoded again.
+//InSourceHash is the content hash of InSource(see LaunchImageContentHash()) the copy is cached under, an unhashed source is decoded for this call only.
+//The bands are launched at the priority of InQoS, batch bands yield to interactive requests before they start.
+//The returned task is completed once OutFiltered is fully written, or once the bands are skipped after InCancellationToken is canceled.
+UE::Tasks::FTask LaunchWavefrontFilter(FSourceImageRef InSource, TOptional<uint64> InSourceHash, FImageBufferRef InVerticalPassResult, FImageBufferRef OutFiltered, EFilterType InFilterType, int32 InFilterSize, FCancellationTokenPtr InCancellationToken = nullptr, const FFilterQoS& InQoS = FFilterQoS());
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ThreadingSample/ThreadingSample.h"
+#include "Tasks/Task.h"
+#include "Async/ParallelFor.h"
+
+//A number of workers shared by the loops that run at the same time, so concurrent loops split the cores instead of each fanning out over all of them.
+//Every filter request owns one(capped by ThreadingSample.WorkerBudget.PerRequest) whose parent is the global budget of all requests,
+//so the concurrent stages of a request split its budget and concurrent requests split the workers.
+class FWorkerBudget
+{
+public:
+	UE_NONCOPYABLE(FWorkerBudget);
+
+	FWorkerBudget(int32 InNumWorkers, TSharedPtr<FWorkerBudget, ESPMode::ThreadSafe> InParent = nullptr);
+
+	//The budget of all filter requests, ThreadingSample.WorkerBudget.Global workers.
+	static const TSharedRef<FWorkerBudget, ESPMode::ThreadSafe>& GetGlobal();
+
+	//Creates the budget of a filter request.
+	static TSharedRef<FWorkerBudget, ESPMode::ThreadSafe> MakeRequestBudget();
+
+	//Grants between 1 and InMaxWorkers workers, the calling thread included, so a loop always makes progress.
+	//A loop gets no more than its fair share of the budget among the loops running at that moment(decided when it starts, not rebalanced later).
+	//Every call must be matched by Release() with the granted number. Can be called from any thread.
+	int32 Acquire(int32 InMaxWorkers);
+
+	void Release(int32 InNumWorkers);
+
+	int32 GetNumWorkers() const
+	{
+		return NumWorkers;
+	}
+
+private:
+	//Counts a loop and grants it up to InMaxHelpers workers beyond its calling thread.
+	int32 AcquireHelpers(int32 InMaxHelpers);
+
+	//Returns the helpers of a loop and stops counting it.
+	void ReleaseHelpers(int32 InNumHelpers);
+
+	const int32 NumWorkers;
+
+	TSharedPtr<FWorkerBudget, ESPMode::ThreadSafe> Parent;
+
+	//Workers not granted to a loop. The calling threads of the loops are not counted, they are busy anyway.
+	std::atomic<int32> NumIdleHelpers;
+
+	std::atomic<int32> NumActiveLoops{ 0 };
+};
+
+using FWorkerBudgetPtr = TSharedPtr<FWorkerBudget, ESPMode::ThreadSafe>;
+
+//A ParallelFor whose fan-out width comes from InBudget. The calling thread and the granted helper tasks pull indices from a shared counter(so they still balance),
+//the helpers are launched at InPriority and waited for(or retracted and run inline) before returning.
+//Falls back to ParallelFor when InBudget is null.
+template<typename BodyType>
+void ParallelForWithBudget(const TCHAR* InDebugName, int32 InNum, FWorkerBudget* InBudget, LowLevelTasks::ETaskPriority InPriority, const BodyType& InBody, EParallelForFlags InFlags = EParallelForFlags::None)
+{
+	if (!InBudget)
+	{
+		ParallelFor(InDebugName, InNum, 1, InBody, InFlags);
+		return;
+	}
+
+	if (InNum <= 0)
+	{
+		return;
+	}
+
+	const int32 NumWorkers = EnumHasAnyFlags(InFlags, EParallelForFlags::ForceSingleThread) ? 1 : InBudget->Acquire(InNum);
+
+	std::atomic<int32> NextIndex{ 0 };
+
+	auto Work = [&NextIndex, InNum, &InBody]()
+		{
+			for (int32 Index = NextIndex.fetch_add(1, std::memory_order_relaxed); Index < InNum; Index = NextIndex.fetch_add(1, std::memory_order_relaxed))
+			{
+				InBody(Index);
+			}
+		};
+
+	TArray<UE::Tasks::FTask, TInlineAllocator<16>> Helpers;
+	Helpers.Reserve(NumWorkers - 1);
+
+	for (int32 Helper = 1; Helper < NumWorkers; ++Helper)
+	{
+		Helpers.Add(UE::Tasks::Launch(InDebugName, Work, InPriority));
+	}
+
+	Work();
+
+	//Helpers that did not start yet run inline(and find no index left).
+	UE::Tasks::Wait(Helpers);
+
+	if (!EnumHasAnyFlags(InFlags, EParallelForFlags::ForceSingleThread))
+	{
+		InBudget->Release(NumWorkers);
+	}
+}
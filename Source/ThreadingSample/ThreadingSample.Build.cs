@@ -6,12 +6,15 @@ public class ThreadingSample : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 	
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "ImageCore" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "AtomicQueue" , "RenderCore", "HTTP", "CoreUObject" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "AtomicQueue" , "RenderCore", "RHI", "HTTP", "CoreUObject" });
 
 		PublicDefinitions.Add("TASKGRAPH_NEW_FRONTEND=1");
 
+		//The coroutine front end of the texture filter pipeline(see TaskCoroutine.h).
+		CppStandard = CppStandardVersion.Cpp20;
+
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		